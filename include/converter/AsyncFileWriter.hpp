@@ -0,0 +1,73 @@
+#ifndef ASYNC_FILE_WRITER_HPP
+#define ASYNC_FILE_WRITER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavformat/version.h>
+}
+
+// Output sink for the muxer: writes are gathered into large buffers that a background thread
+// pwrite()s at their file offsets, so the encoding thread only blocks when the disk falls more
+// than one buffer behind.
+class AsyncFileWriter {
+public:
+    AsyncFileWriter(const std::string& path, std::size_t buffer_bytes);
+    // Best effort: flushes and joins the writer thread, discarding any error.
+    ~AsyncFileWriter();
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    // Owned by this object; attach to AVFormatContext::pb together with AVFMT_FLAG_CUSTOM_IO.
+    AVIOContext* Context() const { return avio_; }
+
+    // Flush everything, wait for the writer thread and close the file. Throws on I/O errors.
+    void Close();
+
+private:
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+    using WriteBuffer = const uint8_t*;
+#else
+    using WriteBuffer = uint8_t*;
+#endif
+
+    struct Chunk {
+        int64_t offset = 0;
+        std::vector<uint8_t> data;
+    };
+
+    static int Write(void* opaque, WriteBuffer buf, int buf_size);
+    static int64_t Seek(void* opaque, int64_t offset, int whence);
+
+    // Queue the active chunk for the writer thread (waiting if one is already queued).
+    bool Submit();
+    void WriterLoop();
+    void Shutdown();
+
+    int fd_;
+    std::size_t buffer_bytes_;
+    AVIOContext* avio_;
+    Chunk active_;
+    int64_t position_;
+    int64_t end_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Chunk> pending_;
+    std::vector<Chunk> spare_;
+    bool writing_;
+    bool stop_;
+    int error_;
+    std::thread thread_;
+};
+
+#endif // ASYNC_FILE_WRITER_HPP
@@ -1,8 +1,16 @@
 #ifndef AUDIO_CONVERTER_HPP
 #define AUDIO_CONVERTER_HPP
 
+#include <atomic>
+#include <chrono>
 #include <string>
 #include <functional>
+#include <memory>
+#include <vector>
+
+#include "converter/ConversionStats.hpp"
+#include "converter/ConverterOptions.hpp"
+#include "converter/ThreadBudget.hpp"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -10,6 +18,44 @@ extern "C" {
 #include <libswresample/swresample.h>
 }
 
+class AsyncFileWriter;
+class AudioConverter;
+class FdStream;
+class MappedInput;
+class ProgressRecord;
+class SampleRingBuffer;
+
+// Outcome of a single file converted as part of a directory job.
+struct FileConversionResult {
+    std::string input_path;
+    std::string output_path;
+    bool success = false;
+    std::string error;
+    // Incremental mode found the output up to date and did not convert it.
+    bool skipped = false;
+    ConversionStats stats;
+};
+
+// One encoder/muxer pair of AudioConverter::ConvertFileFanout.
+struct FanoutOutput {
+    std::string output_path;
+    // Bitrate in bits per second; 0 keeps the bitrate of the converter that encodes this output.
+    int bitrate = 0;
+    // Converter whose codec settings this output is encoded with (only read during the call);
+    // nullptr uses the converter ConvertFileFanout is called on.
+    const AudioConverter* encoder = nullptr;
+};
+
+// Tuning for the parallel directory walk.
+struct ParallelOptions {
+    // Number of converter threads; 0 uses the hardware concurrency.
+    int worker_count = 0;
+    // Maximum number of discovered files waiting for a worker; bounds memory on huge trees.
+    std::size_t queue_capacity = 256;
+    // Invoked from worker threads after each file finishes (successfully or not).
+    std::function<void(const FileConversionResult&)> on_file_done;
+};
+
 // Abstract base for audio converters built on libav*.
 // Derived classes supply codec-specific configuration while the base handles
 // file I/O, resampling, encoding loop, and cleanup.
@@ -18,23 +64,93 @@ public:
     explicit AudioConverter(int bitrate);
     virtual ~AudioConverter();
 
-    // Convert a single input file to the provided output path.
-    void ConvertFile(const std::string& input_path, const std::string& output_path);
+    // Convert a single input file to the provided output path and return its stage counters.
+    ConversionStats ConvertFile(const std::string& input_path, const std::string& output_path);
+
+    // Same as above with segment-parallel encoding settings for this call only. Inputs at least
+    // segments.min_duration_seconds long are split into segments.count time ranges that are
+    // encoded concurrently and stitched into one stream.
+    ConversionStats ConvertFile(const std::string& input_path, const std::string& output_path, const SegmentOptions& segments);
+
+    // Decode and resample the input once and encode it into every output in the same pass, e.g.
+    // one track at several bitrates. Outputs whose encoders take the same rate, layout and sample
+    // format share one resampler. Returns the counters of the whole pass, decoding counted once.
+    // Pipelining, segments and the dedup cache do not apply.
+    ConversionStats ConvertFileFanout(const std::string& input_path, const std::vector<FanoutOutput>& outputs);
+
+    // Streaming conversion between file descriptors (pipes allowed, neither needs to be seekable).
+    // Ogg pages are written to output_fd as soon as they are muxed; descriptors stay open.
+    // When the input has no duration, progress follows bytes consumed out of expected_input_bytes
+    // (taken from fstat for regular files when 0 is passed).
+    ConversionStats ConvertStream(int input_fd, int output_fd, int64_t expected_input_bytes = 0);
 
     // Recursively walk a directory, converting all ".mp3" (or other) files to the output tree.
+    // With ConverterOptions::incremental, inputs recorded as converted in the output tree's
+    // manifest with the same size, mtime and ConfigFingerprint() are skipped.
     // Derived classes can override ShouldConvertFile if they need a different extension filter.
     void ConvertDirectory(const std::string& input_dir, const std::string& output_dir);
 
-    // Register a progress callback (0.0 - 1.0) that the converter will invoke as samples are processed.
-    void SetProgressCallback(std::function<void(double)> cb) { progress_cb_ = std::move(cb); }
+    // Parallel variant: the calling thread walks the tree and feeds a bounded queue drained by
+    // worker threads, each owning its own converter from Clone(). Returns one result per file,
+    // sorted by input path; conversion errors are reported there instead of being swallowed.
+    std::vector<FileConversionResult> ConvertDirectory(const std::string& input_dir,
+                                                       const std::string& output_dir,
+                                                       const ParallelOptions& options);
+
+    // Every setting that changes the encoded output. Incremental runs re-convert files whose
+    // manifest entry was written under a different fingerprint. No whitespace allowed.
+    virtual std::string ConfigFingerprint() const;
+
+    // Whether a directory walk would pick up this file (extension filter from ShouldConvertFile).
+    bool AcceptsInput(const std::string& input_path) const;
+
+    // Whether both paths name the same existing file (device and inode), e.g. an .opus input
+    // mapped onto itself under stream copy. Conversions refuse such outputs; walks skip them.
+    static bool SameFile(const std::string& a, const std::string& b);
+
+    // Register a progress callback (0.0 - 1.0) that the converter will invoke as samples are processed,
+    // at most once per interval plus a final 1.0. It runs on the thread doing the encoding; a
+    // segmented conversion calls it from its segment threads, never two at a time.
+    void SetProgressCallback(std::function<void(double)> cb,
+                             std::chrono::milliseconds interval = std::chrono::milliseconds(100)) {
+        progress_cb_ = std::move(cb);
+        progress_interval_ = interval;
+    }
+
+    // Publish progress on every tick into a lock-free record that other threads poll, e.g. a UI
+    // render loop. The record must outlive the conversions; nullptr detaches it.
+    void SetProgressRecord(ProgressRecord* record) { progress_record_ = record; }
+
+    // Register a callback that receives running counters at most once per interval while a
+    // conversion is in progress. It runs on the thread doing the encoding.
+    void SetStatsCallback(std::function<void(const ConversionStats&)> cb,
+                          std::chrono::milliseconds interval = std::chrono::milliseconds(500)) {
+        stats_cb_ = std::move(cb);
+        stats_interval_ = interval;
+    }
+
+    // Runtime options applied to subsequent conversions (and to clones used by parallel jobs).
+    void SetOptions(const ConverterOptions& options) { options_ = options; }
+    const ConverterOptions& Options() const { return options_; }
+
+    // Buffer (re)allocations made inside the decode/encode loop of the last ConvertFile call.
+    // Frames and the FIFO are pre-sized before the loop, so this stays at zero in steady state
+    // (checked by the hot_loop_allocations test).
+    int64_t HotLoopAllocationCount() const { return hot_loop_allocations_; }
 
 protected:
+    // Fresh converter with the same settings, used to give each worker thread its own contexts.
+    virtual std::unique_ptr<AudioConverter> Clone() const = 0;
+
     // Codec/format hooks that derived classes must implement.
     virtual AVCodecID OutputCodecId() const = 0;
     virtual void ConfigureOutputCodecContext(AVCodecContext& output_ctx, const AVCodecContext& input_ctx) = 0;
     virtual std::string PreferredContainer(const std::string& output_path) const = 0;
     virtual int TargetFrameSize(const AVCodecContext& output_ctx) const;
     virtual bool ShouldConvertFile(const std::string& extension) const;
+    // Whether an input stream may be remuxed as-is under ConverterOptions::stream_copy. The
+    // default requires OutputCodecId() and a bitrate (0 = unknown) within the tolerance.
+    virtual bool CanStreamCopy(const AVCodecParameters& input, int64_t input_bitrate) const;
 
     int bitrate_bps_;
 
@@ -44,16 +160,102 @@ protected:
     AVCodecContext* input_codec_ctx_;
     AVCodecContext* output_codec_ctx_;
     SwrContext* resample_ctx_;
+    // How decoded samples reach the FIFO, chosen by SetupResampler: through swresample, copied
+    // as-is when rate, layout and sample format already match the encoder, or converted by
+    // SampleRingBuffer::WriteConverted (SIMD repack and s16<->float) when only the format differs.
+    enum class SamplePath { Resample, Passthrough, Convert };
+    SamplePath sample_path_;
     int audio_stream_index_;
     std::function<void(double)> progress_cb_;
+    ConverterOptions options_;
+    int64_t hot_loop_allocations_;
+    std::unique_ptr<MappedInput> mapped_input_;
+    std::unique_ptr<AsyncFileWriter> output_writer_;
+    std::unique_ptr<FdStream> stream_input_;
+    std::unique_ptr<FdStream> stream_output_;
+    int64_t expected_input_bytes_;
+    StatsCollector stats_;
+    std::function<void(const ConversionStats&)> stats_cb_;
+    std::chrono::milliseconds stats_interval_;
+    std::chrono::steady_clock::time_point stats_started_;
+    std::chrono::steady_clock::time_point last_stats_report_;
+    std::chrono::milliseconds progress_interval_;
+    std::chrono::steady_clock::time_point last_progress_report_;
+    ProgressRecord* progress_record_;
+    uint64_t progress_file_id_;
+    // Decided per conversion by LeaseThreads from what the thread budget granted.
+    bool pipeline_granted_;
+    int codec_extra_threads_;
+    // sample_path_ and resample_ctx_ match the open decoder and encoder (kept by reuse_codecs).
+    bool resampler_ready_;
 
 private:
     void InitLibav();
+    // Output samples [start, end) of one segment; warmup samples either side are encoded and dropped.
+    struct SegmentRange {
+        int64_t start = 0;
+        int64_t end = 0;
+        int64_t warmup = 0;
+        bool last = false;
+    };
+
+    ThreadBudget::Lease LeaseThreads();
+    void AttachInputIO(AVIOContext* io);
     void OpenInputFile(const std::string& input_path);
-    void SetupOutputFile(const std::string& output_path);
+    bool InputParametersKnown() const;
+    bool CanReuseDecoder(const AVCodecParameters& par) const;
+    void OpenEncoder();
+    // With stream_copy the output stream takes the input's codec parameters and no encoder is opened.
+    void SetupOutputFile(const std::string& output_path, bool stream_copy = false);
     void SetupResampler();
+    bool StreamCopyApplies() const;
+    void RemuxAudio();
     void ConvertAudio();
+    void ConvertAudioPipelined();
+    // Encoder/muxer pair of a fan-out pass and the outputs sharing one resampler.
+    struct FanoutSink;
+    struct FanoutGroup;
+    void ConvertAudioFanout(std::vector<std::unique_ptr<FanoutSink>>& sinks);
+    int SegmentCountForInput() const;
+    int SegmentWarmupSamples() const;
+    void ConvertSegmented(const std::string& input_path, int segment_count);
+    // Returns early, with packets incomplete, once abort is set.
+    void EncodeSegment(const std::string& input_path,
+                       const SegmentRange& range,
+                       std::vector<AVPacket*>& packets,
+                       const std::function<void(int64_t)>& on_samples,
+                       const std::atomic<bool>& abort);
+    void AllocateAudioFrame(AVFrame* frame, int nb_samples);
+    int64_t ExpectedOutputSamples() const;
+    int InitialResampledCapacity() const;
+    int ResampleIntoFifo(AVFrame* input_frame,
+                         AVFrame* resampled_frame,
+                         int& resampled_capacity,
+                         SampleRingBuffer& fifo,
+                         int64_t& allocations);
+    void FillOutputFrame(AVFrame* output_frame, SampleRingBuffer& fifo, int nb_samples, int64_t& allocations);
+    void EncodeAndWrite(AVFrame* frame, AVPacket* packet);
+    // Timed and counted wrappers around the libav calls of each stage.
+    int ReadPacket(AVPacket* packet);
+    int SendToDecoder(AVPacket* packet);
+    int ReceiveDecoded(AVFrame* frame);
+    int SendToEncoder(AVFrame* frame);
+    int ReceiveEncoded(AVPacket* packet);
+    void WritePacket(AVPacket* packet);
+    void WriteTrailer();
+    void BeginStats();
+    ConversionStats FinishStats();
+    void ReportProgress(int64_t processed_samples, int64_t expected_samples);
+    void ReportProgressComplete();
+    void ReleaseLinkedOutput(const std::string& output_path);
+    // Cleanup is CloseFile (formats and I/O of one conversion) plus ReleaseCodecs (decoder,
+    // encoder, resampler); reuse_codecs skips ReleaseCodecs between ConvertFile calls.
     void Cleanup();
+    void CloseFile();
+    void ReleaseCodecs();
+    std::string OutputPathFor(const std::string& input_file,
+                              const std::string& input_dir,
+                              const std::string& output_dir) const;
 };
 
 #endif // AUDIO_CONVERTER_HPP
@@ -0,0 +1,31 @@
+#ifndef CONTENT_HASHER_HPP
+#define CONTENT_HASHER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Streaming XXH64: a fast non-cryptographic 64-bit hash, good enough to key a cache of files
+// when combined with their size. Input is read as little-endian words.
+class ContentHasher {
+public:
+    explicit ContentHasher(uint64_t seed = 0);
+
+    void Update(const void* data, std::size_t size);
+    uint64_t Digest() const;
+
+    // Hash a whole file with large sequential reads. Throws std::runtime_error on I/O errors.
+    static uint64_t HashFile(const std::filesystem::path& path, uint64_t& size);
+    static uint64_t HashString(const std::string& text, uint64_t seed = 0);
+    static std::string ToHex(uint64_t value);
+
+private:
+    uint64_t acc_[4];
+    unsigned char buffer_[32];
+    std::size_t buffered_;
+    uint64_t total_;
+    uint64_t seed_;
+};
+
+#endif // CONTENT_HASHER_HPP
@@ -0,0 +1,60 @@
+#ifndef CONVERSION_MANIFEST_HPP
+#define CONVERSION_MANIFEST_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Record of inputs already converted into an output tree, used to skip unchanged files on
+// re-runs. Stored as a plain text file inside the output directory, one input per line.
+// All members are safe to call from several worker threads. Several instances (or processes)
+// may share one file: saves hold a lock file and merge this instance's changes into what is
+// on disk, so concurrent runs into one output tree keep each other's entries.
+class ConversionManifest {
+public:
+    struct Entry {
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        std::string fingerprint;
+    };
+
+    explicit ConversionManifest(std::filesystem::path file);
+
+    // Default location inside an output tree.
+    static std::filesystem::path PathFor(const std::filesystem::path& output_dir);
+
+    // Key of an input: its canonical absolute path, so inputs from different trees converted
+    // into one output tree never share an entry.
+    static std::string KeyFor(const std::filesystem::path& input);
+
+    // Size and modification time of an input; false if it cannot be stat'ed.
+    static bool Describe(const std::filesystem::path& input, const std::string& fingerprint, Entry& entry);
+
+    // A missing file leaves the manifest empty; malformed lines are ignored.
+    void Load();
+    // Atomically replace the file (write + rename) with the entries on disk plus this instance's
+    // changes. No-op when nothing changed since the last save.
+    void Save();
+    // Save only if at least interval has passed since the last save; bounds work lost to a kill.
+    void Checkpoint(std::chrono::seconds interval);
+
+    bool IsCurrent(const std::string& key, const Entry& entry) const;
+    void Record(const std::string& key, const Entry& entry);
+    void Forget(const std::string& key);
+
+private:
+    void SaveLocked();
+
+    std::filesystem::path file_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    // Keys recorded or forgotten since the last save.
+    std::unordered_set<std::string> changed_;
+    std::chrono::steady_clock::time_point last_save_;
+};
+
+#endif // CONVERSION_MANIFEST_HPP
@@ -0,0 +1,69 @@
+#ifndef CONVERSION_STATS_HPP
+#define CONVERSION_STATS_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// Per-conversion counters. Stage times are the wall time spent inside the named libav calls,
+// summed over every thread involved, so in pipelined or segmented mode they can exceed wall_ns.
+struct ConversionStats {
+    int64_t wall_ns = 0;
+    int64_t demux_ns = 0;    // av_read_frame
+    int64_t decode_ns = 0;   // avcodec_send_packet / avcodec_receive_frame
+    int64_t resample_ns = 0; // swr_convert plus the FIFO write
+    int64_t encode_ns = 0;   // avcodec_send_frame / avcodec_receive_packet
+    int64_t mux_ns = 0;      // av_write_frame / av_write_trailer
+
+    int64_t bytes_read = 0;
+    int64_t bytes_written = 0;
+    int64_t packets_read = 0; // audio packets handed to the decoder
+    int64_t packets_written = 0;
+    int64_t frames_decoded = 0;
+    int64_t frames_encoded = 0;
+    int64_t samples_encoded = 0;
+    int peak_fifo_samples = 0;
+
+    int64_t hash_ns = 0;    // hashing the input for the dedup cache
+    bool cache_hit = false; // output was served from the dedup cache without converting
+    bool stream_copied = false; // input packets were remuxed without decoding (ConverterOptions::stream_copy)
+};
+
+// Live counters behind ConversionStats. Stages on different threads update them with relaxed
+// atomics so a stats callback can take a snapshot mid-conversion.
+class StatsCollector {
+public:
+    StatsCollector() { Reset(); }
+
+    StatsCollector(const StatsCollector&) = delete;
+    StatsCollector& operator=(const StatsCollector&) = delete;
+
+    void Reset();
+    void RaisePeakFifo(int samples);
+    // Fold in counters from another converter (segment workers).
+    void Merge(const ConversionStats& other);
+    ConversionStats Snapshot() const;
+
+    static void Add(std::atomic<int64_t>& counter, int64_t value) {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    std::atomic<int64_t> wall_ns;
+    std::atomic<int64_t> demux_ns;
+    std::atomic<int64_t> decode_ns;
+    std::atomic<int64_t> resample_ns;
+    std::atomic<int64_t> encode_ns;
+    std::atomic<int64_t> mux_ns;
+    std::atomic<int64_t> bytes_read;
+    std::atomic<int64_t> bytes_written;
+    std::atomic<int64_t> packets_read;
+    std::atomic<int64_t> packets_written;
+    std::atomic<int64_t> frames_decoded;
+    std::atomic<int64_t> frames_encoded;
+    std::atomic<int64_t> samples_encoded;
+    std::atomic<int> peak_fifo_samples;
+    std::atomic<int64_t> hash_ns;
+    std::atomic<bool> cache_hit;
+    std::atomic<bool> stream_copied;
+};
+
+#endif // CONVERSION_STATS_HPP
@@ -0,0 +1,34 @@
+#ifndef DEDUP_CACHE_HPP
+#define DEDUP_CACHE_HPP
+
+#include <filesystem>
+#include <string>
+
+// Content-addressed store of converted outputs. Entries are keyed by a hash of the input bytes
+// and of the encoder fingerprint, so the same audio under another name (or path) is served by
+// linking or copying the earlier output instead of re-encoding it.
+//
+// Outputs are hardlinked into the cache when it shares their filesystem; callers must replace
+// an output (unlink + create), never rewrite it in place, or every linked copy changes too.
+class DedupCache {
+public:
+    explicit DedupCache(std::filesystem::path root);
+
+    // Cache key for an input converted under the given fingerprint. Reads the whole input;
+    // throws std::runtime_error if it cannot.
+    std::string KeyFor(const std::filesystem::path& input, const std::string& fingerprint) const;
+
+    // Materialise a cached output at the given path (hardlink, else reflink, else copy).
+    // Returns false on a miss or if the output could not be created.
+    bool Fetch(const std::string& key, const std::filesystem::path& output) const;
+
+    // Publish a freshly converted output. Best effort: failures only cost a future cache hit.
+    void Store(const std::string& key, const std::filesystem::path& output) const;
+
+private:
+    std::filesystem::path EntryPath(const std::string& key) const;
+
+    std::filesystem::path root_;
+};
+
+#endif // DEDUP_CACHE_HPP
@@ -0,0 +1,45 @@
+#ifndef FD_STREAM_HPP
+#define FD_STREAM_HPP
+
+#include <atomic>
+#include <cstdint>
+
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavformat/version.h>
+}
+
+// Non-seekable AVIOContext over a caller-owned file descriptor (pipe, socket or file), used to
+// run conversions inside shell pipelines. The descriptor is never closed by this object.
+class FdStream {
+public:
+    enum class Mode { Read, Write };
+
+    FdStream(int fd, Mode mode);
+    ~FdStream();
+
+    FdStream(const FdStream&) = delete;
+    FdStream& operator=(const FdStream&) = delete;
+
+    // Owned by this object; attach to AVFormatContext::pb together with AVFMT_FLAG_CUSTOM_IO.
+    AVIOContext* Context() const { return avio_; }
+
+    // Bytes read from or written to the descriptor so far; safe to poll from another thread.
+    int64_t BytesTransferred() const { return bytes_.load(std::memory_order_relaxed); }
+
+private:
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+    using WriteBuffer = const uint8_t*;
+#else
+    using WriteBuffer = uint8_t*;
+#endif
+
+    static int Read(void* opaque, uint8_t* buf, int buf_size);
+    static int Write(void* opaque, WriteBuffer buf, int buf_size);
+
+    int fd_;
+    AVIOContext* avio_;
+    std::atomic<int64_t> bytes_;
+};
+
+#endif // FD_STREAM_HPP
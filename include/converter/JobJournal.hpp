@@ -0,0 +1,46 @@
+#ifndef JOB_JOURNAL_HPP
+#define JOB_JOURNAL_HPP
+
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Append-only on-disk log of a job queue, so a crashed or restarted batch resumes exactly the
+// jobs that never finished. Every record is written to the file immediately (a process crash
+// loses nothing); fdatasync is batched for the frequent started/finished/failed records and
+// immediate for enqueue/remove, so a power loss costs at most the last batch of completions.
+// All members are safe to call from several worker threads.
+class JobJournal {
+public:
+    enum class Event { Enqueued, Started, Finished, Failed, Removed };
+
+    explicit JobJournal(std::filesystem::path file);
+    ~JobJournal();
+
+    JobJournal(const JobJournal&) = delete;
+    JobJournal& operator=(const JobJournal&) = delete;
+
+    // Replay the journal, rewrite it to hold only the unfinished jobs and open it for appending.
+    // Returns those jobs in their original enqueue order; jobs that were started but never
+    // finished count as unfinished. Throws std::runtime_error on I/O errors.
+    std::vector<std::string> Open();
+
+    // Throws std::runtime_error if the record cannot be written.
+    void Record(Event event, const std::string& job);
+
+    // Force outstanding records to stable storage.
+    void Sync();
+
+private:
+    void SyncLocked();
+
+    std::filesystem::path file_;
+    int fd_;
+    std::mutex mutex_;
+    int unsynced_records_;
+    std::chrono::steady_clock::time_point last_sync_;
+};
+
+#endif // JOB_JOURNAL_HPP
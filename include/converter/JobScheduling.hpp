@@ -0,0 +1,59 @@
+#ifndef JOB_SCHEDULING_HPP
+#define JOB_SCHEDULING_HPP
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class AudioConverter;
+
+// Order in which queued jobs are handed to conversion workers.
+enum class SchedulingPolicy {
+    // As queued.
+    Fifo,
+    // Shortest estimated audio first: short files report back early, minimising mean latency.
+    ShortestFirst,
+    // Longest first: long files start early instead of straggling after the rest, minimising
+    // the time until a batch on parallel workers is done.
+    LongestFirst,
+};
+
+// "fifo", "shortest" or "longest"; throws std::runtime_error for anything else.
+SchedulingPolicy SchedulingPolicyFromName(const std::string& name);
+const std::vector<std::string>& SchedulingPolicyNames();
+
+// Seconds of audio in a job. Files use the duration from their container header when it has
+// one (no packets are decoded), otherwise their size; directories sum the sizes of the files
+// filter would convert.
+double EstimateJobSeconds(const std::string& path, const AudioConverter& filter);
+
+// Reorder jobs for the policy by the estimate of the path path_of(job) names; jobs with equal
+// estimates keep their queue order.
+template <typename Job, typename PathOf>
+void ScheduleJobs(std::vector<Job>& jobs, SchedulingPolicy policy, const AudioConverter& filter, PathOf path_of) {
+    if (policy == SchedulingPolicy::Fifo || jobs.size() < 2) {
+        return;
+    }
+    std::vector<std::pair<double, Job>> keyed;
+    keyed.reserve(jobs.size());
+    for (Job& job : jobs) {
+        const double seconds = EstimateJobSeconds(path_of(job), filter);
+        keyed.emplace_back(seconds, std::move(job));
+    }
+    std::stable_sort(keyed.begin(), keyed.end(), [policy](const auto& a, const auto& b) {
+        return policy == SchedulingPolicy::ShortestFirst ? a.first < b.first : a.first > b.first;
+    });
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        jobs[i] = std::move(keyed[i].second);
+    }
+}
+
+// Reorder a queue by estimates gathered beforehand, e.g. off the thread that owns the queue.
+// Jobs without an estimate (queued meanwhile, or not estimable) go last in queue order.
+void OrderJobs(std::vector<std::string>& jobs,
+               SchedulingPolicy policy,
+               const std::unordered_map<std::string, double>& seconds);
+
+#endif // JOB_SCHEDULING_HPP
@@ -2,19 +2,28 @@
 #define MP3_TO_OPUS_CONVERTER_HPP
 
 #include "converter/AudioConverter.hpp"
+#include "converter/OpusProfile.hpp"
 
 // Concrete converter that transcodes MP3 input to Opus output.
 class MP3ToOpusConverter : public AudioConverter {
 public:
-    explicit MP3ToOpusConverter(int bitrate);
+    // Throws std::runtime_error if the profile is invalid (see OpusProfile::Validate).
+    explicit MP3ToOpusConverter(int bitrate, const OpusProfile& profile = OpusProfile());
     ~MP3ToOpusConverter() override = default;
 
+    std::string ConfigFingerprint() const override;
+    const OpusProfile& Profile() const { return profile_; }
+
 protected:
+    std::unique_ptr<AudioConverter> Clone() const override;
     AVCodecID OutputCodecId() const override;
     void ConfigureOutputCodecContext(AVCodecContext& output_ctx, const AVCodecContext& input_ctx) override;
     std::string PreferredContainer(const std::string& output_path) const override;
     int TargetFrameSize(const AVCodecContext& output_ctx) const override;
     bool ShouldConvertFile(const std::string& extension) const override;
+
+private:
+    OpusProfile profile_;
 };
 
 #endif // MP3_TO_OPUS_CONVERTER_HPP
@@ -0,0 +1,37 @@
+#ifndef MAPPED_INPUT_HPP
+#define MAPPED_INPUT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+extern "C" {
+#include <libavformat/avio.h>
+}
+
+// Read-only memory mapping of an input file served to libavformat through a custom AVIOContext.
+// Reads are plain copies out of the mapping (advised MADV_SEQUENTIAL), so demuxing issues no
+// read(2) calls once the file is mapped.
+class MappedInput {
+public:
+    explicit MappedInput(const std::string& path);
+    ~MappedInput();
+
+    MappedInput(const MappedInput&) = delete;
+    MappedInput& operator=(const MappedInput&) = delete;
+
+    // Owned by this object; attach to AVFormatContext::pb together with AVFMT_FLAG_CUSTOM_IO.
+    AVIOContext* Context() const { return avio_; }
+    std::size_t Size() const { return size_; }
+
+private:
+    static int Read(void* opaque, uint8_t* buf, int buf_size);
+    static int64_t Seek(void* opaque, int64_t offset, int whence);
+
+    const uint8_t* data_;
+    std::size_t size_;
+    std::size_t pos_;
+    AVIOContext* avio_;
+};
+
+#endif // MAPPED_INPUT_HPP
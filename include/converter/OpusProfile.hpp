@@ -0,0 +1,34 @@
+#ifndef OPUS_PROFILE_HPP
+#define OPUS_PROFILE_HPP
+
+#include <string>
+#include <vector>
+
+// Opus encoder speed/quality settings applied by MP3ToOpusConverter. The defaults are the
+// "archival" profile, which matches what the converter always used before profiles existed.
+struct OpusProfile {
+    std::string name = "archival";
+    // libopus complexity 0-10; 10 costs roughly twice the CPU of 5.
+    int complexity = 10;
+    // Samples per channel at 48 kHz: 120, 240, 480, 960, 1920 or 2880 (2.5 - 60 ms).
+    int frame_size = 960;
+    // libopus application mode: "audio", "voip" or "lowdelay".
+    std::string application = "audio";
+    // "off", "on" or "constrained".
+    std::string vbr = "on";
+
+    // Built-in profile by name (fast, balanced, archival, speech); throws for unknown names.
+    static OpusProfile Named(const std::string& name);
+    static const std::vector<std::string>& Names();
+
+    // Throws std::runtime_error when a field is outside what libopus accepts.
+    void Validate() const;
+
+    // Frame duration in milliseconds, as the libopus "frame_duration" option expects.
+    double FrameDurationMs() const { return frame_size / 48.0; }
+
+    // Settings that change the encoded output, for ConfigFingerprint.
+    std::string Fingerprint() const;
+};
+
+#endif // OPUS_PROFILE_HPP
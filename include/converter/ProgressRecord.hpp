@@ -0,0 +1,37 @@
+#ifndef PROGRESS_RECORD_HPP
+#define PROGRESS_RECORD_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// Progress of one converter, published by the thread doing the encoding and sampled by any number
+// of readers (e.g. a render loop) without locks. A seqlock keeps the three fields consistent:
+// readers retry while a publish is in flight instead of blocking the writer.
+// There must be one writer at a time; AudioConverter serialises its segment workers itself.
+class ProgressRecord {
+public:
+    struct Snapshot {
+        // Work done and expected, in output samples (input bytes for streams without a duration).
+        int64_t samples_done = 0;
+        int64_t samples_expected = 0;
+        // Changes whenever the writer starts another file.
+        uint64_t file_id = 0;
+
+        // 0.0 - 1.0, or 0.0 while the total is unknown.
+        double Fraction() const;
+    };
+
+    void Publish(int64_t samples_done, int64_t samples_expected, uint64_t file_id);
+    // Mark the current file finished (done == expected, or 1/1 when the total was never known).
+    void Complete();
+
+    Snapshot Read() const;
+
+private:
+    std::atomic<uint32_t> sequence_{0};
+    std::atomic<int64_t> samples_done_{0};
+    std::atomic<int64_t> samples_expected_{0};
+    std::atomic<uint64_t> file_id_{0};
+};
+
+#endif // PROGRESS_RECORD_HPP
@@ -0,0 +1,34 @@
+#ifndef SAMPLE_KERNELS_HPP
+#define SAMPLE_KERNELS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Same-rate sample conversions used instead of swresample when only the plane layout or the
+// s16/float sample type differs. Each entry point picks an AVX2, SSE2 or scalar implementation
+// once at first use, based on what the running CPU supports. Against swr_convert on 1152-sample
+// chunks held in cache, AVX2 is 1.1-1.3x faster on stereo and about 2.5x on mono planar to
+// interleaved; SSE2 is on par. On buffers streamed from memory all of them are on par.
+namespace SampleKernels {
+
+// Name of the implementation selected for this CPU ("avx2", "sse2" or "scalar").
+const char* ActiveIsa();
+
+// Planar <-> interleaved for 32-bit samples (float or s32); count is samples per channel.
+void Interleave32(const uint32_t* const* planes, uint32_t* interleaved, std::size_t count, int channels);
+void Deinterleave32(const uint32_t* interleaved, uint32_t* const* planes, std::size_t count, int channels);
+
+// s16 <-> float over count contiguous values. Floats are scaled to [-1, 1); the reverse
+// direction rounds to nearest and saturates like swresample.
+void S16ToFloat(const int16_t* in, float* out, std::size_t count);
+void FloatToS16(const float* in, int16_t* out, std::size_t count);
+
+// Scalar reference versions, always available (used for odd channel counts and by the benchmark).
+void Interleave32Scalar(const uint32_t* const* planes, uint32_t* interleaved, std::size_t count, int channels);
+void Deinterleave32Scalar(const uint32_t* interleaved, uint32_t* const* planes, std::size_t count, int channels);
+void S16ToFloatScalar(const int16_t* in, float* out, std::size_t count);
+void FloatToS16Scalar(const float* in, int16_t* out, std::size_t count);
+
+} // namespace SampleKernels
+
+#endif // SAMPLE_KERNELS_HPP
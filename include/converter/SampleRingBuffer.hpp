@@ -0,0 +1,65 @@
+#ifndef SAMPLE_RING_BUFFER_HPP
+#define SAMPLE_RING_BUFFER_HPP
+
+#include <cstdint>
+
+extern "C" {
+#include <libavutil/samplefmt.h>
+}
+
+// Fixed-capacity FIFO of audio samples, used between the resampler and the encoder.
+// All planes live in one aligned allocation and wrap around instead of moving data,
+// so once sized the buffer never reallocates or memmoves.
+class SampleRingBuffer {
+public:
+    SampleRingBuffer();
+    ~SampleRingBuffer();
+
+    SampleRingBuffer(const SampleRingBuffer&) = delete;
+    SampleRingBuffer& operator=(const SampleRingBuffer&) = delete;
+
+    // Allocate storage for the given layout and discard any buffered samples.
+    void Reset(AVSampleFormat sample_fmt, int channels, int capacity);
+
+    // Grow to at least the given capacity, keeping buffered samples. Returns true if it reallocated.
+    bool Reserve(int capacity);
+
+    // Copy samples in/out using the same plane layout as AVFrame::data.
+    // Both return false without touching the buffer when there is not enough space/data.
+    bool Write(const uint8_t* const* data, int nb_samples);
+    bool Read(uint8_t* const* data, int nb_samples);
+
+    // Write samples given in another format, converting on the way in (see CanConvert). Uses the
+    // SampleKernels SIMD paths for planar<->interleaved and s16<->float. Same failure rule as Write.
+    bool WriteConverted(const uint8_t* const* data, int nb_samples, AVSampleFormat source_fmt);
+
+    // Whether WriteConverted handles from -> to: any plane layout change of the same sample type,
+    // and s16 <-> float (with a layout change only up to eight channels).
+    static bool CanConvert(AVSampleFormat from, AVSampleFormat to, int channels);
+
+    // Drop the oldest samples without copying them out.
+    void Discard(int nb_samples);
+
+    void Clear() { head_ = 0; size_ = 0; }
+
+    int Size() const { return size_; }
+    int Capacity() const { return capacity_; }
+    int Space() const { return capacity_ - size_; }
+
+private:
+    uint8_t* Plane(int plane) const { return storage_ + static_cast<std::size_t>(plane) * plane_stride_; }
+    void ConvertBlock(const uint8_t* const* data, AVSampleFormat source_fmt, int src_offset, int dst_offset, int count);
+
+    uint8_t* storage_;
+    std::size_t plane_stride_;
+    AVSampleFormat sample_fmt_;
+    int planes_;
+    int channels_;
+    int bytes_per_sample_; // bytes of one channel's sample
+    int sample_bytes_; // bytes per sample in one plane (all channels when interleaved)
+    int capacity_;
+    int head_;
+    int size_;
+};
+
+#endif // SAMPLE_RING_BUFFER_HPP
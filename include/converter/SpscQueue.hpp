@@ -0,0 +1,51 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded lock-free single-producer/single-consumer ring.
+// Exactly one thread may call TryPush and exactly one (other) thread may call TryPop.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(std::size_t capacity) {
+        std::size_t size = 2;
+        while (size < capacity + 1) {
+            size <<= 1;
+        }
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    bool TryPush(const T& value) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        const std::size_t next = (tail + 1) & mask_;
+        if (next == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots_[tail] = value;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& out) {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = slots_[head];
+        head_.store((head + 1) & mask_, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> slots_;
+    std::size_t mask_ = 0;
+    // Producer and consumer indices on separate cache lines to avoid false sharing.
+    alignas(64) std::atomic<std::size_t> head_{0};
+    alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+#endif // SPSC_QUEUE_HPP
@@ -0,0 +1,61 @@
+#ifndef THREAD_BUDGET_HPP
+#define THREAD_BUDGET_HPP
+
+#include <condition_variable>
+#include <mutex>
+
+// Process-wide cap on runnable conversion threads. Every conversion holds a Lease for its
+// duration: one thread for itself plus whatever it can use on top (pipeline stages, segments,
+// codec-internal threads). Concurrent files and per-file threads therefore share one pool and
+// never add up to more than the cores the process was allotted.
+class ThreadBudget {
+public:
+    // Threads granted by Acquire/TryAcquire, returned to the budget on destruction.
+    class Lease {
+    public:
+        Lease() = default;
+        ~Lease();
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        int Threads() const { return threads_; }
+        // Give back everything above the given count (at least one thread is kept).
+        void Shrink(int threads);
+
+    private:
+        friend class ThreadBudget;
+        Lease(ThreadBudget* budget, int threads) : budget_(budget), threads_(threads) {}
+
+        ThreadBudget* budget_ = nullptr;
+        int threads_ = 0;
+    };
+
+    // capacity <= 0 uses the hardware concurrency.
+    explicit ThreadBudget(int capacity = 0);
+
+    // Shared by every converter in the process.
+    static ThreadBudget& Global();
+
+    // Takes effect for later acquisitions; leases already granted are not revoked.
+    void SetCapacity(int capacity);
+    int Capacity() const;
+    int Available() const;
+
+    // Block until a thread is free, then take up to wanted (at least one).
+    Lease Acquire(int wanted);
+    // Like Acquire but returns an empty lease (Threads() == 0) instead of waiting.
+    Lease TryAcquire(int wanted);
+
+private:
+    void Release(int threads);
+    int GrantLocked(int wanted);
+
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+    int capacity_;
+    int in_use_ = 0;
+};
+
+#endif // THREAD_BUDGET_HPP
@@ -0,0 +1,30 @@
+#ifndef TUI_CONVERTER_SETTINGS_HPP
+#define TUI_CONVERTER_SETTINGS_HPP
+
+#include <string>
+
+#include "converter/ConverterOptions.hpp"
+#include "converter/JobScheduling.hpp"
+#include "converter/OpusProfile.hpp"
+#include "tui/Config.hpp"
+
+// Translate the converter.yml keys shared by the TUI and the headless CLI into core options.
+ConverterOptions ConverterOptionsFromConfig(const ConverterConfig& config);
+
+// Opus bitrate in bits per second.
+int BitrateFromConfig(const ConverterConfig& config);
+
+// Encoder profile named by opus_profile (or profile_name when non-empty), with opus_frame_size
+// (when non-zero) and opus_use_vbr: false applied on top. Throws for unknown or invalid settings.
+OpusProfile OpusProfileFromConfig(const ConverterConfig& config, const std::string& profile_name = "");
+
+// Job order named by job_order (or policy_name when non-empty); throws for unknown names.
+SchedulingPolicy SchedulingPolicyFromConfig(const ConverterConfig& config, const std::string& policy_name = "");
+
+// Configured worker count, resolving 0 (the default) to the hardware concurrency.
+int WorkerCountFromConfig(const ConverterConfig& config);
+
+// Total conversion threads for ThreadBudget::Global() (thread_budget; 0 = all cores).
+int ThreadBudgetFromConfig(const ConverterConfig& config);
+
+#endif // TUI_CONVERTER_SETTINGS_HPP
@@ -13,7 +13,9 @@
 #include "tui/Subframe.hpp"
 #include "tui/FileBrowser.hpp"
 #include "tui/Config.hpp"
+#include "converter/JobJournal.hpp"
 #include "converter/MP3ToOpusConverter.hpp"
+#include "converter/ProgressRecord.hpp"
 
 // Minimal test screen: just a framed title for layout experiments.
 class TestScreen : public BaseScreen {
@@ -78,9 +80,13 @@ private:
         void HandleInputPublic(uint32_t input, const ncinput& details) { HandleInput(input, details); }
         std::string RemoveSelected();
         void Tick();
-        void BeginConversionDisplay(const std::string& file_name);
-        void EndConversionDisplay();
-        void UpdateProgress(double value);
+        // Per-worker progress slots; SetWorkerCount must be called before a batch starts.
+        void SetWorkerCount(std::size_t count);
+        // Called on the worker's own thread, the only writer of its progress record.
+        void BeginConversionDisplay(std::size_t worker, const std::string& file_name);
+        void EndConversionDisplay(std::size_t worker);
+        // Record the worker's converter publishes into; the render loop samples it without locking.
+        ProgressRecord* ProgressFor(std::size_t worker);
         void SetFocused(bool focused) { focused_ = focused; }
 
     protected:
@@ -94,8 +100,15 @@ private:
         void HandleInput(uint32_t input, const ncinput& details) override;
 
     private:
+        struct WorkerSlot {
+            bool active = false;
+            std::string file_name;
+            ProgressRecord* progress = nullptr;
+        };
+
         void DrawList();
-        void DrawProgressBar(int bar_row, int bar_left, int bar_width);
+        void DrawWorkers(const ContentArea& area);
+        void DrawProgressBar(int bar_row, int bar_left, int bar_width, double value);
 
         std::vector<std::string>* jobs_;
         int selected_index_ = 0;
@@ -103,11 +116,8 @@ private:
         bool is_left_;
         int horizontal_offset_ = 0;
         bool focused_ = false;
-        double progress_ = 0.0;
-        double fill_speed_ = 0.003; // columns per frame
-        bool converting_display_ = false;
-        std::string converting_file_;
-        double progress_value_ = 0.0;
+        std::vector<WorkerSlot> worker_slots_;
+        std::vector<std::unique_ptr<ProgressRecord>> progress_records_;
         std::mutex* jobs_mutex_ = nullptr;
         std::mutex convert_mutex_;
     };
@@ -166,6 +176,8 @@ private:
     public:
         JobConfigSubframe(bool is_left, ConverterConfig& config);
         void SetFocused(bool focused) { focused_ = focused; }
+        // Index of the choice picked for an option, or -1 while it is still unset.
+        int Selection(const std::string& key) const;
         void HandleInputPublic(uint32_t input, const ncinput& details) { HandleInput(input, details); }
 
     protected:
@@ -241,14 +253,23 @@ private:
     JobConfigSubframe job_config_subframe_;
     CommandSubframe command_subframe_;
 
-    // Conversion worker
-    std::thread worker_;
+    // Conversion worker pool; each worker owns its converter and pulls from jobs_.
+    std::vector<std::thread> workers_;
     std::atomic<bool> stop_flag_{false};
     std::atomic<bool> converting_{false};
+    std::atomic<int> active_workers_{0};
     std::mutex jobs_mutex_;
+    // On-disk mirror of jobs_ so an interrupted batch resumes on the next start (null if disabled).
+    std::unique_ptr<JobJournal> journal_;
 
+    // Every job writes under output_folder at its input's absolute path: /music/a/x.mp3 becomes
+    // <output_folder>/music/a/x.opus, whether queued alone or through /music or /music/a.
+    // Jobs that would write the same outputs as an earlier one (the same path again, a file or
+    // folder inside a queued folder, a.mp3 next to a queued a.opus) are dropped from the batch.
     void StartConversions();
     void StopConversions();
+    void JoinWorkers();
+    void RecordJob(JobJournal::Event event, const std::string& job);
 };
 
 #endif // TUI_TESTSCREEN_HPP
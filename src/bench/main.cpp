@@ -0,0 +1,709 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "converter/MP3ToOpusConverter.hpp"
+#include "converter/SampleKernels.hpp"
+#include "converter/SampleRingBuffer.hpp"
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/opt.h>
+#include <libswresample/swresample.h>
+}
+
+// Microbenchmarks for the conversion hot loop. Each stage (decode, resample, FIFO, encode, mux)
+// runs in isolation on pre-computed inputs from the previous stage, followed by end-to-end runs of
+// MP3ToOpusConverter in its different I/O modes, all on the same synthetic MP3.
+
+namespace {
+std::atomic<int64_t> g_heap_allocations{0};
+}
+
+// Count C++ heap allocations made anywhere in the process. libav buffers (av_malloc) are not seen
+// here; the end-to-end rows report those through HotLoopAllocationCount().
+void* operator new(std::size_t size) {
+    g_heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+constexpr int kInputSampleRate = 44100;
+constexpr int kKernelSampleRate = 48000;
+// Samples per call in the format conversion rows, one MP3 frame like the production loop.
+constexpr int kKernelChunk = 1152;
+constexpr double kPi = 3.14159265358979323846;
+// Small-file batch rows: many short clips behind a large ID3v2 tag, where opening each input
+// costs about as much as converting it.
+constexpr int kClipCount = 200;
+constexpr double kClipSeconds = 2.0;
+constexpr std::size_t kClipTagBytes = 256 * 1024;
+
+struct BenchArgs {
+    double seconds = 60.0;
+    int iterations = 3;
+    std::string input;
+    std::filesystem::path work_dir = std::filesystem::temp_directory_path() / "audio_converter_bench";
+    // Only convert and verify that HotLoopAllocationCount() stays at zero (run by ctest).
+    bool check_allocations = false;
+};
+
+struct StageResult {
+    std::string name;
+    int64_t samples = 0;
+    int sample_rate = 0;
+    double seconds = 0.0;
+    int64_t allocations = 0;
+    int64_t hot_loop_allocations = -1;
+};
+
+struct FrameDeleter {
+    void operator()(AVFrame* frame) const { av_frame_free(&frame); }
+};
+struct PacketDeleter {
+    void operator()(AVPacket* packet) const { av_packet_free(&packet); }
+};
+struct CodecDeleter {
+    void operator()(AVCodecContext* ctx) const { avcodec_free_context(&ctx); }
+};
+struct InputFormatDeleter {
+    void operator()(AVFormatContext* ctx) const { avformat_close_input(&ctx); }
+};
+struct SwrDeleter {
+    void operator()(SwrContext* ctx) const { swr_free(&ctx); }
+};
+
+using FramePtr = std::unique_ptr<AVFrame, FrameDeleter>;
+using PacketPtr = std::unique_ptr<AVPacket, PacketDeleter>;
+using CodecPtr = std::unique_ptr<AVCodecContext, CodecDeleter>;
+using InputFormatPtr = std::unique_ptr<AVFormatContext, InputFormatDeleter>;
+using SwrPtr = std::unique_ptr<SwrContext, SwrDeleter>;
+
+// Exposes the production encoder configuration so the isolated stages match ConvertFile.
+class BenchConverter : public MP3ToOpusConverter {
+public:
+    using MP3ToOpusConverter::MP3ToOpusConverter;
+    using MP3ToOpusConverter::ConfigureOutputCodecContext;
+    using MP3ToOpusConverter::TargetFrameSize;
+};
+
+void Check(int ret, const char* what) {
+    if (ret < 0) {
+        throw std::runtime_error(what);
+    }
+}
+
+FramePtr MakeAudioFrame(AVSampleFormat fmt, const AVChannelLayout& layout, int sample_rate, int nb_samples) {
+    FramePtr frame(av_frame_alloc());
+    if (!frame) {
+        throw std::bad_alloc();
+    }
+    frame->format = fmt;
+    frame->sample_rate = sample_rate;
+    frame->nb_samples = nb_samples;
+    Check(av_channel_layout_copy(&frame->ch_layout, &layout), "Could not copy channel layout");
+    Check(av_frame_get_buffer(frame.get(), 0), "Could not allocate frame buffer");
+    return frame;
+}
+
+// Two-tone test signal with a little high-frequency content so the encoders have real work to do.
+void FillTone(AVFrame* frame, int64_t first_sample) {
+    const AVSampleFormat fmt = static_cast<AVSampleFormat>(frame->format);
+    const int channels = frame->ch_layout.nb_channels;
+    for (int i = 0; i < frame->nb_samples; ++i) {
+        const double t = static_cast<double>(first_sample + i) / frame->sample_rate;
+        for (int c = 0; c < channels; ++c) {
+            const double v = 0.4 * std::sin(2.0 * kPi * (440.0 + 110.0 * c) * t) + 0.1 * std::sin(2.0 * kPi * 3520.0 * t);
+            switch (fmt) {
+                case AV_SAMPLE_FMT_FLTP:
+                    reinterpret_cast<float*>(frame->data[c])[i] = static_cast<float>(v);
+                    break;
+                case AV_SAMPLE_FMT_S16P:
+                    reinterpret_cast<int16_t*>(frame->data[c])[i] = static_cast<int16_t>(v * 32767.0);
+                    break;
+                case AV_SAMPLE_FMT_FLT:
+                    reinterpret_cast<float*>(frame->data[0])[i * channels + c] = static_cast<float>(v);
+                    break;
+                case AV_SAMPLE_FMT_S16:
+                    reinterpret_cast<int16_t*>(frame->data[0])[i * channels + c] = static_cast<int16_t>(v * 32767.0);
+                    break;
+                default:
+                    throw std::runtime_error("Unsupported sample format for synthetic input");
+            }
+        }
+    }
+}
+
+AVSampleFormat PickSampleFormat(const AVCodec* codec) {
+    if (codec->sample_fmts == nullptr) {
+        return AV_SAMPLE_FMT_FLTP;
+    }
+    for (int i = 0; codec->sample_fmts[i] != AV_SAMPLE_FMT_NONE; ++i) {
+        const AVSampleFormat fmt = codec->sample_fmts[i];
+        if (fmt == AV_SAMPLE_FMT_FLTP || fmt == AV_SAMPLE_FMT_S16P || fmt == AV_SAMPLE_FMT_FLT || fmt == AV_SAMPLE_FMT_S16) {
+            return fmt;
+        }
+    }
+    throw std::runtime_error("MP3 encoder offers no supported sample format");
+}
+
+void WriteEncodedPackets(AVCodecContext* enc, AVFormatContext* out, AVPacket* packet) {
+    while (avcodec_receive_packet(enc, packet) == 0) {
+        av_packet_rescale_ts(packet, enc->time_base, out->streams[0]->time_base);
+        packet->stream_index = 0;
+        Check(av_interleaved_write_frame(out, packet), "Could not write MP3 packet");
+    }
+}
+
+// Encode seconds of stereo 44.1 kHz test tone to an MP3 file.
+void GenerateMp3(const std::filesystem::path& path, double seconds, std::size_t tag_bytes = 0) {
+    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_MP3);
+    if (codec == nullptr) {
+        throw std::runtime_error("No MP3 encoder available; pass --input with an existing MP3");
+    }
+    CodecPtr enc(avcodec_alloc_context3(codec));
+    const AVChannelLayout stereo = AV_CHANNEL_LAYOUT_STEREO;
+    Check(av_channel_layout_copy(&enc->ch_layout, &stereo), "Could not set channel layout");
+    enc->sample_rate = kInputSampleRate;
+    enc->sample_fmt = PickSampleFormat(codec);
+    enc->bit_rate = 192000;
+    enc->time_base = AVRational{1, kInputSampleRate};
+    Check(avcodec_open2(enc.get(), codec, nullptr), "Could not open MP3 encoder");
+
+    AVFormatContext* out = nullptr;
+    Check(avformat_alloc_output_context2(&out, nullptr, "mp3", path.c_str()), "Could not create MP3 muxer");
+    std::unique_ptr<AVFormatContext, void (*)(AVFormatContext*)> out_guard(out, [](AVFormatContext* ctx) {
+        avio_closep(&ctx->pb);
+        avformat_free_context(ctx);
+    });
+    AVStream* stream = avformat_new_stream(out, nullptr);
+    Check(avcodec_parameters_from_context(stream->codecpar, enc.get()), "Could not copy MP3 parameters");
+    stream->time_base = enc->time_base;
+    if (tag_bytes > 0) {
+        // Written into the ID3v2 tag ahead of the first frame.
+        av_dict_set(&out->metadata, "comment", std::string(tag_bytes, 'x').c_str(), 0);
+    }
+    Check(avio_open(&out->pb, path.c_str(), AVIO_FLAG_WRITE), "Could not open synthetic input for writing");
+    Check(avformat_write_header(out, nullptr), "Could not write MP3 header");
+
+    const int frame_size = enc->frame_size > 0 ? enc->frame_size : 1152;
+    const int64_t total = static_cast<int64_t>(seconds * kInputSampleRate);
+    PacketPtr packet(av_packet_alloc());
+    for (int64_t pos = 0; pos < total; pos += frame_size) {
+        const int n = static_cast<int>(std::min<int64_t>(frame_size, total - pos));
+        FramePtr frame = MakeAudioFrame(enc->sample_fmt, enc->ch_layout, enc->sample_rate, n);
+        FillTone(frame.get(), pos);
+        frame->pts = pos;
+        Check(avcodec_send_frame(enc.get(), frame.get()), "Could not encode MP3 frame");
+        WriteEncodedPackets(enc.get(), out, packet.get());
+    }
+    avcodec_send_frame(enc.get(), nullptr);
+    WriteEncodedPackets(enc.get(), out, packet.get());
+    Check(av_write_trailer(out), "Could not finalise MP3");
+}
+
+struct DecodedInput {
+    CodecPtr decoder;
+    std::vector<FramePtr> frames;
+    int64_t samples = 0;
+};
+
+void DrainDecoder(DecodedInput& decoded) {
+    while (true) {
+        FramePtr frame(av_frame_alloc());
+        if (avcodec_receive_frame(decoded.decoder.get(), frame.get()) < 0) {
+            return;
+        }
+        decoded.samples += frame->nb_samples;
+        decoded.frames.push_back(std::move(frame));
+    }
+}
+
+DecodedInput DecodeAll(const std::string& path) {
+    AVFormatContext* raw = nullptr;
+    Check(avformat_open_input(&raw, path.c_str(), nullptr, nullptr), "Could not open bench input");
+    InputFormatPtr input(raw);
+    Check(avformat_find_stream_info(input.get(), nullptr), "Could not read stream info");
+    const AVCodec* codec = nullptr;
+    const int stream_index = av_find_best_stream(input.get(), AVMEDIA_TYPE_AUDIO, -1, -1, &codec, 0);
+    Check(stream_index, "No audio stream in bench input");
+
+    DecodedInput decoded;
+    decoded.decoder.reset(avcodec_alloc_context3(codec));
+    Check(avcodec_parameters_to_context(decoded.decoder.get(), input->streams[stream_index]->codecpar),
+          "Could not copy decoder parameters");
+    Check(avcodec_open2(decoded.decoder.get(), codec, nullptr), "Could not open decoder");
+
+    PacketPtr packet(av_packet_alloc());
+    while (av_read_frame(input.get(), packet.get()) >= 0) {
+        if (packet->stream_index == stream_index && avcodec_send_packet(decoded.decoder.get(), packet.get()) >= 0) {
+            DrainDecoder(decoded);
+        }
+        av_packet_unref(packet.get());
+    }
+    avcodec_send_packet(decoded.decoder.get(), nullptr);
+    DrainDecoder(decoded);
+    return decoded;
+}
+
+CodecPtr OpenEncoder(BenchConverter& config, const AVCodecContext& decoder) {
+    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_OPUS);
+    if (codec == nullptr) {
+        throw std::runtime_error("Opus encoder not found");
+    }
+    CodecPtr enc(avcodec_alloc_context3(codec));
+    config.ConfigureOutputCodecContext(*enc, decoder);
+    enc->time_base = AVRational{1, enc->sample_rate};
+    Check(avcodec_open2(enc.get(), codec, nullptr), "Could not open Opus encoder");
+    return enc;
+}
+
+std::vector<FramePtr> Resample(const AVCodecContext& dec, const AVCodecContext& enc, const std::vector<FramePtr>& input) {
+    SwrContext* raw = nullptr;
+    Check(swr_alloc_set_opts2(&raw, &enc.ch_layout, enc.sample_fmt, enc.sample_rate,
+                              &dec.ch_layout, dec.sample_fmt, dec.sample_rate, 0, nullptr),
+          "Could not configure resampler");
+    SwrPtr swr(raw);
+    Check(swr_init(swr.get()), "Could not initialise resampler");
+
+    std::vector<FramePtr> output;
+    output.reserve(input.size() + 1);
+    for (const FramePtr& in : input) {
+        FramePtr out = MakeAudioFrame(enc.sample_fmt, enc.ch_layout, enc.sample_rate,
+                                      swr_get_out_samples(swr.get(), in->nb_samples));
+        const int converted = swr_convert(swr.get(), out->data, out->nb_samples,
+                                          const_cast<const uint8_t**>(in->extended_data), in->nb_samples);
+        Check(converted, "Resampling failed");
+        out->nb_samples = converted;
+        output.push_back(std::move(out));
+    }
+    const int tail = swr_get_out_samples(swr.get(), 0);
+    if (tail > 0) {
+        FramePtr out = MakeAudioFrame(enc.sample_fmt, enc.ch_layout, enc.sample_rate, tail);
+        out->nb_samples = std::max(0, swr_convert(swr.get(), out->data, tail, nullptr, 0));
+        output.push_back(std::move(out));
+    }
+    return output;
+}
+
+// Regroup resampled frames into encoder-sized frames through the same ring buffer ConvertAudio uses.
+// With collected == nullptr every frame is read into one reused buffer, like the production loop.
+int64_t Reframe(const std::vector<FramePtr>& input,
+                const AVCodecContext& enc,
+                int frame_size,
+                std::vector<FramePtr>* collected) {
+    int largest = 0;
+    for (const FramePtr& frame : input) {
+        largest = std::max(largest, frame->nb_samples);
+    }
+    SampleRingBuffer fifo;
+    fifo.Reset(enc.sample_fmt, enc.ch_layout.nb_channels, largest + frame_size);
+    FramePtr scratch = MakeAudioFrame(enc.sample_fmt, enc.ch_layout, enc.sample_rate, frame_size);
+
+    int64_t samples = 0;
+    auto emit = [&](int n) {
+        if (collected != nullptr) {
+            FramePtr frame = MakeAudioFrame(enc.sample_fmt, enc.ch_layout, enc.sample_rate, n);
+            fifo.Read(frame->data, n);
+            frame->pts = samples;
+            collected->push_back(std::move(frame));
+        } else {
+            fifo.Read(scratch->data, n);
+        }
+        samples += n;
+    };
+    for (const FramePtr& frame : input) {
+        if (!fifo.Write(frame->data, frame->nb_samples)) {
+            throw std::runtime_error("Ring buffer overflow");
+        }
+        while (fifo.Size() >= frame_size) {
+            emit(frame_size);
+        }
+    }
+    if (fifo.Size() > 0) {
+        emit(fifo.Size());
+    }
+    return samples;
+}
+
+void DrainEncoder(AVCodecContext* enc, std::vector<PacketPtr>* packets) {
+    while (true) {
+        PacketPtr packet(av_packet_alloc());
+        if (avcodec_receive_packet(enc, packet.get()) < 0) {
+            return;
+        }
+        if (packets != nullptr) {
+            packets->push_back(std::move(packet));
+        }
+    }
+}
+
+int64_t Encode(BenchConverter& config,
+               const AVCodecContext& dec,
+               const std::vector<FramePtr>& frames,
+               std::vector<PacketPtr>* packets) {
+    CodecPtr enc = OpenEncoder(config, dec);
+    int64_t samples = 0;
+    for (const FramePtr& frame : frames) {
+        Check(avcodec_send_frame(enc.get(), frame.get()), "Encoding failed");
+        samples += frame->nb_samples;
+        DrainEncoder(enc.get(), packets);
+    }
+    avcodec_send_frame(enc.get(), nullptr);
+    DrainEncoder(enc.get(), packets);
+    return samples;
+}
+
+// Mux into an in-memory buffer so the stage measures the Ogg muxer, not the disk.
+void Mux(const AVCodecContext& enc, const std::vector<PacketPtr>& packets) {
+    AVFormatContext* out = nullptr;
+    Check(avformat_alloc_output_context2(&out, nullptr, "opus", nullptr), "Could not create Ogg muxer");
+    std::unique_ptr<AVFormatContext, void (*)(AVFormatContext*)> out_guard(out, [](AVFormatContext* ctx) {
+        if (ctx->pb != nullptr) {
+            uint8_t* buffer = nullptr;
+            avio_close_dyn_buf(ctx->pb, &buffer);
+            av_free(buffer);
+        }
+        avformat_free_context(ctx);
+    });
+    AVStream* stream = avformat_new_stream(out, nullptr);
+    Check(avcodec_parameters_from_context(stream->codecpar, &enc), "Could not copy Opus parameters");
+    stream->time_base = enc.time_base;
+    Check(avio_open_dyn_buf(&out->pb), "Could not open memory output");
+    Check(avformat_write_header(out, nullptr), "Could not write Ogg header");
+
+    PacketPtr packet(av_packet_alloc());
+    for (const PacketPtr& source : packets) {
+        Check(av_packet_ref(packet.get(), source.get()), "Could not reference packet");
+        av_packet_rescale_ts(packet.get(), enc.time_base, stream->time_base);
+        packet->stream_index = 0;
+        Check(av_write_frame(out, packet.get()), "Could not mux packet");
+        av_packet_unref(packet.get());
+    }
+    Check(av_write_trailer(out), "Could not finalise Ogg stream");
+}
+
+// Same-rate format conversion of a whole buffer in decoder-sized chunks, through swresample or the
+// SampleKernels routines SampleRingBuffer::WriteConverted uses. Returns samples per channel.
+int64_t ConvertFormat(const AVFrame& in, AVFrame& out, bool use_swr) {
+    const int channels = in.ch_layout.nb_channels;
+    const AVSampleFormat in_fmt = static_cast<AVSampleFormat>(in.format);
+    const AVSampleFormat out_fmt = static_cast<AVSampleFormat>(out.format);
+    SwrPtr swr;
+    if (use_swr) {
+        SwrContext* raw = nullptr;
+        Check(swr_alloc_set_opts2(&raw, &out.ch_layout, out_fmt, out.sample_rate,
+                                  &in.ch_layout, in_fmt, in.sample_rate, 0, nullptr),
+              "Could not configure resampler");
+        swr.reset(raw);
+        Check(swr_init(swr.get()), "Could not initialise resampler");
+    }
+
+    const bool in_planar = av_sample_fmt_is_planar(in_fmt) != 0;
+    const bool out_planar = av_sample_fmt_is_planar(out_fmt) != 0;
+    const int in_unit = av_get_bytes_per_sample(in_fmt) * (in_planar ? 1 : channels);
+    const int out_unit = av_get_bytes_per_sample(out_fmt) * (out_planar ? 1 : channels);
+    std::vector<const uint8_t*> src(static_cast<std::size_t>(channels));
+    std::vector<uint8_t*> dst(static_cast<std::size_t>(channels));
+    for (int offset = 0; offset < in.nb_samples; offset += kKernelChunk) {
+        const int n = std::min(kKernelChunk, in.nb_samples - offset);
+        for (int c = 0; c < (in_planar ? channels : 1); ++c) {
+            src[static_cast<std::size_t>(c)] = in.extended_data[c] + static_cast<std::size_t>(offset) * in_unit;
+        }
+        for (int c = 0; c < (out_planar ? channels : 1); ++c) {
+            dst[static_cast<std::size_t>(c)] = out.extended_data[c] + static_cast<std::size_t>(offset) * out_unit;
+        }
+        if (use_swr) {
+            Check(swr_convert(swr.get(), dst.data(), n, src.data(), n), "Resampling failed");
+        } else if (in_fmt == AV_SAMPLE_FMT_FLTP && out_fmt == AV_SAMPLE_FMT_FLT) {
+            SampleKernels::Interleave32(reinterpret_cast<const uint32_t* const*>(src.data()),
+                                        reinterpret_cast<uint32_t*>(dst[0]), static_cast<std::size_t>(n), channels);
+        } else if (in_fmt == AV_SAMPLE_FMT_S16 && out_fmt == AV_SAMPLE_FMT_FLT) {
+            SampleKernels::S16ToFloat(reinterpret_cast<const int16_t*>(src[0]), reinterpret_cast<float*>(dst[0]),
+                                      static_cast<std::size_t>(n) * static_cast<std::size_t>(channels));
+        } else {
+            throw std::runtime_error("No kernel for this conversion");
+        }
+    }
+    return in.nb_samples;
+}
+
+// Run body iterations times and keep the fastest run; body returns the samples it processed.
+StageResult Measure(const std::string& name, int sample_rate, int iterations, const std::function<int64_t()>& body) {
+    StageResult best;
+    best.name = name;
+    best.sample_rate = sample_rate;
+    for (int i = 0; i < iterations; ++i) {
+        const int64_t allocations_before = g_heap_allocations.load(std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+        const int64_t samples = body();
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || elapsed < best.seconds) {
+            best.samples = samples;
+            best.seconds = elapsed;
+            best.allocations = g_heap_allocations.load(std::memory_order_relaxed) - allocations_before;
+        }
+    }
+    return best;
+}
+
+StageResult MeasureEndToEnd(const std::string& name,
+                            const BenchArgs& args,
+                            const std::string& input,
+                            int64_t input_samples,
+                            const ConverterOptions& options) {
+    const std::string output = (args.work_dir / "bench_output.opus").string();
+    MP3ToOpusConverter converter(128000);
+    converter.SetOptions(options);
+    StageResult result = Measure(name, kInputSampleRate, args.iterations, [&]() {
+        converter.ConvertFile(input, output);
+        return input_samples;
+    });
+    result.hot_loop_allocations = converter.HotLoopAllocationCount();
+    return result;
+}
+
+StageResult MeasureBatch(const std::string& name,
+                         const BenchArgs& args,
+                         const std::vector<std::string>& clips,
+                         int64_t clip_samples,
+                         const ConverterOptions& options) {
+    const std::string output = (args.work_dir / "bench_clip_output.opus").string();
+    MP3ToOpusConverter converter(128000);
+    converter.SetOptions(options);
+    return Measure(name, kInputSampleRate, args.iterations, [&]() {
+        for (const std::string& clip : clips) {
+            converter.ConvertFile(clip, output);
+        }
+        return clip_samples * static_cast<int64_t>(clips.size());
+    });
+}
+
+void PrintResults(const std::vector<StageResult>& results) {
+    std::printf("%-26s %14s %10s %12s %14s\n", "stage", "samples/s", "realtime", "allocs/s", "hot-loop allocs");
+    for (const StageResult& r : results) {
+        const double seconds = std::max(r.seconds, 1e-9);
+        const double audio_seconds = static_cast<double>(r.samples) / r.sample_rate;
+        std::printf("%-26s %14.0f %9.1fx %12.0f", r.name.c_str(), r.samples / seconds, audio_seconds / seconds,
+                    r.allocations / seconds);
+        if (r.hot_loop_allocations >= 0) {
+            std::printf(" %14lld", static_cast<long long>(r.hot_loop_allocations));
+        }
+        std::printf("\n");
+    }
+}
+
+// Converts input in each end-to-end mode; returns the number of modes whose hot loop allocated.
+int CheckHotLoopAllocations(const BenchArgs& args, const std::string& input) {
+    const std::string output = (args.work_dir / "check_output.opus").string();
+    ConverterOptions plain;
+    ConverterOptions pipelined;
+    pipelined.pipelined = true;
+    ConverterOptions buffered;
+    buffered.mmap_input = true;
+    buffered.output_buffer_bytes = 1 << 20;
+    const std::pair<const char*, ConverterOptions> modes[] = {
+        {"plain", plain}, {"pipelined", pipelined}, {"mmap+async out", buffered}};
+
+    int failures = 0;
+    for (const auto& [name, options] : modes) {
+        MP3ToOpusConverter converter(128000);
+        converter.SetOptions(options);
+        converter.ConvertFile(input, output);
+        const int64_t allocations = converter.HotLoopAllocationCount();
+        std::printf("%-16s hot-loop allocations: %lld\n", name, static_cast<long long>(allocations));
+        if (allocations != 0) {
+            ++failures;
+        }
+    }
+    return failures;
+}
+
+void PrintUsage() {
+    std::cout << "Usage: audio_converter_bench [--seconds N] [--iterations N] [--input FILE] [--work-dir DIR]\n"
+                 "                             [--check-allocations]\n"
+                 "Times decode, resample, FIFO, encode and mux in isolation and end to end, and\n"
+                 "compares swresample with the SIMD sample kernels on same-rate format conversions.\n"
+                 "Batch rows convert 200 synthetic 2 s clips with a 256 KiB ID3v2 tag under each\n"
+                 "input-opening mode (default probing, bounded probing, fast open).\n"
+                 "Without --input a synthetic stereo 44.1 kHz MP3 of --seconds (default 60) is generated.\n"
+                 "Each row reports the fastest of --iterations (default 3) runs.\n"
+                 "--check-allocations times nothing: it converts the input in every I/O mode and exits\n"
+                 "non-zero unless each conversion made no buffer allocations in its hot loop.\n";
+}
+
+bool ParseArgs(int argc, char** argv, BenchArgs& args) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--check-allocations") {
+            args.check_allocations = true;
+            continue;
+        }
+        if (arg == "-h" || arg == "--help" || i + 1 >= argc) {
+            return false;
+        }
+        const std::string value = argv[++i];
+        try {
+            if (arg == "--seconds") {
+                args.seconds = std::stod(value);
+            } else if (arg == "--iterations") {
+                args.iterations = std::max(1, std::stoi(value));
+            } else if (arg == "--input") {
+                args.input = value;
+            } else if (arg == "--work-dir") {
+                args.work_dir = value;
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return args.seconds > 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchArgs args;
+    if (!ParseArgs(argc, argv, args)) {
+        PrintUsage();
+        return 2;
+    }
+
+    try {
+        std::filesystem::create_directories(args.work_dir);
+        std::string input = args.input;
+        if (input.empty()) {
+            input = (args.work_dir / "bench_input.mp3").string();
+            GenerateMp3(input, args.seconds);
+        }
+        if (args.check_allocations) {
+            return CheckHotLoopAllocations(args, input) == 0 ? 0 : 1;
+        }
+
+        // Untimed setup: materialise every stage's input once.
+        BenchConverter config(128000);
+        const DecodedInput decoded = DecodeAll(input);
+        const AVCodecContext& dec = *decoded.decoder;
+        const CodecPtr enc = OpenEncoder(config, dec);
+        const int frame_size = config.TargetFrameSize(*enc);
+        const std::vector<FramePtr> resampled = Resample(dec, *enc, decoded.frames);
+        std::vector<FramePtr> encoder_frames;
+        Reframe(resampled, *enc, frame_size, &encoder_frames);
+        std::vector<PacketPtr> packets;
+        const int64_t encoded_samples = Encode(config, dec, encoder_frames, &packets);
+
+        std::vector<StageResult> results;
+        results.push_back(Measure("decode", dec.sample_rate, args.iterations, [&]() {
+            return DecodeAll(input).samples;
+        }));
+        results.push_back(Measure("resample", enc->sample_rate, args.iterations, [&]() {
+            int64_t samples = 0;
+            for (const FramePtr& frame : Resample(dec, *enc, decoded.frames)) {
+                samples += frame->nb_samples;
+            }
+            return samples;
+        }));
+        results.push_back(Measure("fifo", enc->sample_rate, args.iterations, [&]() {
+            return Reframe(resampled, *enc, frame_size, nullptr);
+        }));
+        results.push_back(Measure("encode", enc->sample_rate, args.iterations, [&]() {
+            return Encode(config, dec, encoder_frames, nullptr);
+        }));
+        results.push_back(Measure("mux", enc->sample_rate, args.iterations, [&]() {
+            Mux(*enc, packets);
+            return encoded_samples;
+        }));
+
+        // Format conversion rows: swresample against the SIMD kernels on the same buffers.
+        const int kernel_samples = static_cast<int>(std::min(args.seconds, 600.0) * kKernelSampleRate);
+        for (int channels : {1, 2}) {
+            AVChannelLayout layout;
+            av_channel_layout_default(&layout, channels);
+            const std::string suffix = channels == 1 ? " mono" : " stereo";
+            FramePtr fltp = MakeAudioFrame(AV_SAMPLE_FMT_FLTP, layout, kKernelSampleRate, kernel_samples);
+            FramePtr s16 = MakeAudioFrame(AV_SAMPLE_FMT_S16, layout, kKernelSampleRate, kernel_samples);
+            FramePtr flt = MakeAudioFrame(AV_SAMPLE_FMT_FLT, layout, kKernelSampleRate, kernel_samples);
+            FillTone(fltp.get(), 0);
+            FillTone(s16.get(), 0);
+            for (const bool use_swr : {true, false}) {
+                const std::string impl = use_swr ? "swr" : SampleKernels::ActiveIsa();
+                results.push_back(Measure(impl + " fltp->flt" + suffix, kKernelSampleRate, args.iterations, [&]() {
+                    return ConvertFormat(*fltp, *flt, use_swr);
+                }));
+                results.push_back(Measure(impl + " s16->flt" + suffix, kKernelSampleRate, args.iterations, [&]() {
+                    return ConvertFormat(*s16, *flt, use_swr);
+                }));
+            }
+            av_channel_layout_uninit(&layout);
+        }
+
+        ConverterOptions options;
+        results.push_back(MeasureEndToEnd("end-to-end", args, input, decoded.samples, options));
+        options.pipelined = true;
+        results.push_back(MeasureEndToEnd("end-to-end pipelined", args, input, decoded.samples, options));
+        options.pipelined = false;
+        options.mmap_input = true;
+        options.output_buffer_bytes = 1 << 20;
+        results.push_back(MeasureEndToEnd("end-to-end mmap+async out", args, input, decoded.samples, options));
+
+        const std::filesystem::path clip_dir = args.work_dir / "clips";
+        std::filesystem::create_directories(clip_dir);
+        const std::filesystem::path first_clip = clip_dir / "clip_0.mp3";
+        GenerateMp3(first_clip, kClipSeconds, kClipTagBytes);
+        std::vector<std::string> clips{first_clip.string()};
+        for (int i = 1; i < kClipCount; ++i) {
+            const std::filesystem::path clip = clip_dir / ("clip_" + std::to_string(i) + ".mp3");
+            std::filesystem::copy_file(first_clip, clip, std::filesystem::copy_options::overwrite_existing);
+            clips.push_back(clip.string());
+        }
+        const int64_t clip_samples = DecodeAll(first_clip.string()).samples;
+        const ConverterOptions batch_defaults;
+        results.push_back(MeasureBatch("batch default probe", args, clips, clip_samples, batch_defaults));
+        // The probe limit has to cover the tag, or libavformat never sees the first frame.
+        ConverterOptions bounded;
+        bounded.probe_size_bytes = 512 * 1024;
+        bounded.analyze_duration_us = 100 * 1000;
+        results.push_back(MeasureBatch("batch probe 512k/100ms", args, clips, clip_samples, bounded));
+        ConverterOptions fast_open;
+        fast_open.fast_open = true;
+        results.push_back(MeasureBatch("batch fast open", args, clips, clip_samples, fast_open));
+        fast_open.reuse_codecs = true;
+        results.push_back(MeasureBatch("batch fast open+reuse dec/swr", args, clips, clip_samples, fast_open));
+
+        std::printf("input: %s (%.1f s of audio)\n\n", input.c_str(),
+                    static_cast<double>(decoded.samples) / dec.sample_rate);
+        PrintResults(results);
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,520 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <unistd.h>
+
+#include "converter/ConversionManifest.hpp"
+#include "converter/JobScheduling.hpp"
+#include "converter/MP3ToOpusConverter.hpp"
+#include "converter/ThreadBudget.hpp"
+#include "tui/Config.hpp"
+#include "tui/ConverterSettings.hpp"
+#include "tui/Signal.hpp"
+
+// Headless batch front end for audio_converter_core: no TTY or notcurses required.
+// Progress and results are printed as one JSON object per line.
+
+namespace {
+
+// Exit statuses, documented in the usage text.
+constexpr int kExitOk = 0;
+constexpr int kExitFailures = 1;
+constexpr int kExitUsage = 2;
+constexpr int kExitNoInput = 3;
+constexpr int kExitInterrupted = 130;
+
+struct CliArgs {
+    std::vector<std::string> inputs;
+    std::string output_dir;
+    std::filesystem::path config_path = std::filesystem::current_path() / "config" / "converter.yml";
+    int jobs = 0;
+    int threads = 0;
+    int bitrate_kbps = 0;
+    std::string profile;
+    std::string order;
+    bool progress = true;
+    bool incremental = false;
+    std::string dedup_cache_dir;
+    bool stream_copy = false;
+    bool fast_open = false;
+};
+
+struct Job {
+    std::filesystem::path input;
+    std::filesystem::path output;
+    // ConversionManifest::KeyFor(input): unique per input even when relative layouts repeat.
+    std::string manifest_key;
+};
+
+void PrintUsage(std::ostream& out) {
+    out << "Usage: audio_converter_cli [options] <input>...\n"
+           "Convert MP3 files or directories (recursively) to Opus.\n"
+           "\n"
+           "  -o, --output DIR     output directory (default: output_folder from the config)\n"
+           "  -c, --config FILE    config file (default: ./config/converter.yml)\n"
+           "  -j, --jobs N         concurrent conversions (default: worker_count from the config)\n"
+           "  -t, --threads N      total threads shared by all conversions (default: thread_budget)\n"
+           "  -b, --bitrate KBPS   Opus bitrate (default: opus_bitrate_kbps from the config)\n"
+           "  -p, --profile NAME   Opus encoder profile: fast, balanced, archival or speech\n"
+           "                       (default: opus_profile from the config)\n"
+           "      --order NAME     job order: fifo, shortest (first) or longest (first)\n"
+           "                       (default: job_order from the config)\n"
+           "  -i, --incremental    skip inputs whose output is up to date (also: incremental in the config)\n"
+           "      --dedup-cache DIR  reuse outputs of identical inputs stored in DIR (also: dedup_cache_dir)\n"
+           "      --stream-copy    remux inputs already in Opus at a close enough bitrate instead of\n"
+           "                       re-encoding them; also picks up .opus inputs (also: stream_copy)\n"
+           "      --fast-open      open inputs with the demuxer named by their extension instead of\n"
+           "                       probing, and skip stream analysis when the header suffices\n"
+           "                       (never for MP3) (also: fast_open)\n"
+           "  -q, --quiet          no progress events, only per-file results and the summary\n"
+           "  -h, --help           show this help\n"
+           "\n"
+           "A single input of \"-\" streams MP3 from stdin to Opus on stdout; events go to stderr.\n"
+           "\n"
+           "Files are written to DIR under their name, files found in a directory input under their\n"
+           "path within it. Inputs that would share an output are reported and nothing is converted.\n"
+           "\n"
+           "Exit status: 0 all converted, 1 some conversions failed, 2 usage or config error\n"
+           "(including colliding outputs), 3 no convertible input found, 130 interrupted.\n";
+}
+
+bool ParseInt(const std::string& text, int& value) {
+    try {
+        std::size_t used = 0;
+        value = std::stoi(text, &used);
+        return used == text.size() && value > 0;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Returns -1 when parsing succeeded, otherwise the exit status to use.
+int ParseArgs(int argc, char** argv, CliArgs& args) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&](std::string& value) {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << "\n";
+                return false;
+            }
+            value = argv[++i];
+            return true;
+        };
+        std::string value;
+        if (arg == "-h" || arg == "--help") {
+            PrintUsage(std::cout);
+            return kExitOk;
+        } else if (arg == "-o" || arg == "--output") {
+            if (!next(args.output_dir)) {
+                return kExitUsage;
+            }
+        } else if (arg == "-c" || arg == "--config") {
+            if (!next(value)) {
+                return kExitUsage;
+            }
+            args.config_path = value;
+        } else if (arg == "-j" || arg == "--jobs") {
+            if (!next(value) || !ParseInt(value, args.jobs)) {
+                std::cerr << "Invalid job count\n";
+                return kExitUsage;
+            }
+        } else if (arg == "-t" || arg == "--threads") {
+            if (!next(value) || !ParseInt(value, args.threads)) {
+                std::cerr << "Invalid thread count\n";
+                return kExitUsage;
+            }
+        } else if (arg == "-b" || arg == "--bitrate") {
+            if (!next(value) || !ParseInt(value, args.bitrate_kbps)) {
+                std::cerr << "Invalid bitrate\n";
+                return kExitUsage;
+            }
+        } else if (arg == "-p" || arg == "--profile") {
+            if (!next(args.profile)) {
+                return kExitUsage;
+            }
+        } else if (arg == "--order") {
+            if (!next(args.order)) {
+                return kExitUsage;
+            }
+        } else if (arg == "-i" || arg == "--incremental") {
+            args.incremental = true;
+        } else if (arg == "--dedup-cache") {
+            if (!next(args.dedup_cache_dir)) {
+                return kExitUsage;
+            }
+        } else if (arg == "--stream-copy") {
+            args.stream_copy = true;
+        } else if (arg == "--fast-open") {
+            args.fast_open = true;
+        } else if (arg == "-q" || arg == "--quiet") {
+            args.progress = false;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "Unknown option " << arg << "\n";
+            return kExitUsage;
+        } else {
+            args.inputs.push_back(arg);
+        }
+    }
+    if (args.inputs.empty()) {
+        PrintUsage(std::cerr);
+        return kExitUsage;
+    }
+    if (args.inputs.size() > 1 && std::find(args.inputs.begin(), args.inputs.end(), "-") != args.inputs.end()) {
+        std::cerr << "\"-\" cannot be combined with other inputs\n";
+        return kExitUsage;
+    }
+    return -1;
+}
+
+std::string JsonEscape(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size() + 2);
+    for (const char c : text) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+                    escaped += buf;
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
+
+std::string StatsJson(const ConversionStats& stats) {
+    std::ostringstream out;
+    out << "{\"wall_ns\":" << stats.wall_ns
+        << ",\"demux_ns\":" << stats.demux_ns
+        << ",\"decode_ns\":" << stats.decode_ns
+        << ",\"resample_ns\":" << stats.resample_ns
+        << ",\"encode_ns\":" << stats.encode_ns
+        << ",\"mux_ns\":" << stats.mux_ns
+        << ",\"bytes_read\":" << stats.bytes_read
+        << ",\"bytes_written\":" << stats.bytes_written
+        << ",\"packets_read\":" << stats.packets_read
+        << ",\"packets_written\":" << stats.packets_written
+        << ",\"frames_decoded\":" << stats.frames_decoded
+        << ",\"frames_encoded\":" << stats.frames_encoded
+        << ",\"samples_encoded\":" << stats.samples_encoded
+        << ",\"peak_fifo_samples\":" << stats.peak_fifo_samples
+        << ",\"hash_ns\":" << stats.hash_ns
+        << ",\"cache_hit\":" << (stats.cache_hit ? "true" : "false")
+        << ",\"stream_copied\":" << (stats.stream_copied ? "true" : "false") << "}";
+    return out.str();
+}
+
+// Serialises event lines from all workers onto one stream.
+class EventWriter {
+public:
+    explicit EventWriter(std::ostream& out) : out_(out) {}
+
+    void Emit(const std::string& line) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out_ << line << '\n';
+        out_.flush();
+    }
+
+private:
+    std::ostream& out_;
+    std::mutex mutex_;
+};
+
+// Expand files and directories into individual jobs, mirroring directory structure under output_root.
+std::vector<Job> CollectJobs(const std::vector<std::string>& inputs,
+                             const std::filesystem::path& output_root,
+                             const AudioConverter& filter) {
+    std::vector<Job> jobs;
+    for (const std::string& raw : inputs) {
+        const std::filesystem::path input(raw);
+        std::error_code ec;
+        if (std::filesystem::is_directory(input, ec)) {
+            const std::filesystem::recursive_directory_iterator end;
+            for (std::filesystem::recursive_directory_iterator it(input, ec); !ec && it != end; it.increment(ec)) {
+                const std::filesystem::directory_entry& entry = *it;
+                if (entry.is_directory() && AudioConverter::SameFile(entry.path().string(), output_root.string())) {
+                    // Outputs of an earlier run inside the input tree are not inputs.
+                    it.disable_recursion_pending();
+                    continue;
+                }
+                if (entry.is_regular_file() && filter.AcceptsInput(entry.path().string())) {
+                    Job job;
+                    job.input = entry.path();
+                    job.manifest_key = ConversionManifest::KeyFor(job.input);
+                    job.output = output_root / std::filesystem::relative(entry.path(), input);
+                    job.output.replace_extension(".opus");
+                    if (AudioConverter::SameFile(job.input.string(), job.output.string())) {
+                        std::cerr << "Skipping " << job.input << ": it is its own output\n";
+                        continue;
+                    }
+                    jobs.push_back(std::move(job));
+                }
+            }
+            if (ec) {
+                std::cerr << "Could not walk " << input << ": " << ec.message() << "\n";
+            }
+        } else if (std::filesystem::is_regular_file(input, ec)) {
+            Job job;
+            job.input = input;
+            job.manifest_key = ConversionManifest::KeyFor(input);
+            job.output = output_root / input.filename();
+            job.output.replace_extension(".opus");
+            if (AudioConverter::SameFile(job.input.string(), job.output.string())) {
+                std::cerr << "Skipping " << job.input << ": it is its own output\n";
+                continue;
+            }
+            jobs.push_back(std::move(job));
+        } else {
+            std::cerr << "Skipping missing input " << input << "\n";
+        }
+    }
+    return jobs;
+}
+
+// Jobs sharing an output (song.mp3 from two inputs, the same layout under two directories, or
+// a.mp3 next to a.opus) would have parallel workers write one file. Reports every clash.
+bool ReportOutputCollisions(const std::vector<Job>& jobs) {
+    std::unordered_map<std::string, const Job*> claimed;
+    bool collided = false;
+    for (const Job& job : jobs) {
+        const auto [it, inserted] = claimed.emplace(job.output.lexically_normal().string(), &job);
+        if (!inserted) {
+            std::cerr << "Output collision: " << it->second->input << " and " << job.input
+                      << " both write " << job.output << "\n";
+            collided = true;
+        }
+    }
+    return collided;
+}
+
+int RunStream(const CliArgs& args, int bitrate_bps, const OpusProfile& profile, const ConverterOptions& options) {
+    // A closed downstream pipe should surface as a write error, not kill the process.
+    std::signal(SIGPIPE, SIG_IGN);
+    EventWriter events(std::cerr);
+    MP3ToOpusConverter converter(bitrate_bps, profile);
+    converter.SetOptions(options);
+    if (args.progress) {
+        int last_percent = -1;
+        converter.SetProgressCallback([&events, &last_percent](double p) {
+            const int percent = static_cast<int>(p * 100.0);
+            if (percent != last_percent) {
+                last_percent = percent;
+                events.Emit("{\"event\":\"progress\",\"input\":\"-\",\"progress\":" + std::to_string(p) + "}");
+            }
+        });
+    }
+    ConversionStats stats;
+    try {
+        stats = converter.ConvertStream(STDIN_FILENO, STDOUT_FILENO);
+    } catch (const std::exception& e) {
+        events.Emit("{\"event\":\"done\",\"input\":\"-\",\"status\":\"error\",\"error\":\"" + JsonEscape(e.what()) + "\"}");
+        return kExitFailures;
+    }
+    events.Emit("{\"event\":\"done\",\"input\":\"-\",\"status\":\"ok\",\"stats\":" + StatsJson(stats) + "}");
+    return kExitOk;
+}
+
+int RunBatch(const CliArgs& args,
+             const ConverterConfig& config,
+             int bitrate_bps,
+             const OpusProfile& profile,
+             SchedulingPolicy order,
+             const ConverterOptions& options) {
+    const std::filesystem::path output_root =
+        args.output_dir.empty() ? std::filesystem::path(config.GetString("output_folder", "out"))
+                                : std::filesystem::path(args.output_dir);
+
+    MP3ToOpusConverter filter(bitrate_bps, profile);
+    filter.SetOptions(options);
+    std::vector<Job> jobs = CollectJobs(args.inputs, output_root, filter);
+    if (jobs.empty()) {
+        std::cerr << "No convertible input found\n";
+        return kExitNoInput;
+    }
+    if (ReportOutputCollisions(jobs)) {
+        return kExitUsage;
+    }
+    // Workers take jobs in index order.
+    ScheduleJobs(jobs, order, filter, [](const Job& job) { return job.input.string(); });
+
+    int worker_count = args.jobs > 0 ? args.jobs : WorkerCountFromConfig(config);
+    worker_count = std::min({worker_count, ThreadBudget::Global().Capacity(), static_cast<int>(jobs.size())});
+
+    std::unique_ptr<ConversionManifest> manifest;
+    std::string fingerprint;
+    if (args.incremental || options.incremental) {
+        std::filesystem::create_directories(output_root);
+        manifest = std::make_unique<ConversionManifest>(ConversionManifest::PathFor(output_root));
+        manifest->Load();
+        fingerprint = filter.ConfigFingerprint();
+    }
+
+    EventWriter events(std::cout);
+    std::atomic<std::size_t> next_job{0};
+    std::atomic<int> succeeded{0};
+    std::atomic<int> failed{0};
+    std::atomic<int> up_to_date{0};
+    const bool progress = args.progress;
+
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<std::size_t>(worker_count));
+    for (int w = 0; w < worker_count; ++w) {
+        workers.emplace_back([&]() {
+            MP3ToOpusConverter converter(bitrate_bps, profile);
+            converter.SetOptions(options);
+            std::string current;
+            int last_percent = -1;
+            if (progress) {
+                converter.SetProgressCallback([&](double p) {
+                    // One event per whole percent keeps output volume independent of frame count.
+                    const int percent = static_cast<int>(p * 100.0);
+                    if (percent != last_percent) {
+                        last_percent = percent;
+                        events.Emit("{\"event\":\"progress\",\"input\":\"" + current + "\",\"progress\":" + std::to_string(p) + "}");
+                    }
+                });
+            }
+
+            while (!g_sigint_received.load(std::memory_order_relaxed)) {
+                const std::size_t index = next_job.fetch_add(1, std::memory_order_relaxed);
+                if (index >= jobs.size()) {
+                    break;
+                }
+                const Job& job = jobs[index];
+                current = JsonEscape(job.input.string());
+                last_percent = -1;
+                std::ostringstream line;
+                line << "{\"event\":\"done\",\"input\":\"" << current
+                     << "\",\"output\":\"" << JsonEscape(job.output.string()) << "\",";
+
+                ConversionManifest::Entry record;
+                const bool tracked = manifest != nullptr && ConversionManifest::Describe(job.input, fingerprint, record);
+                std::error_code ec;
+                if (tracked && manifest->IsCurrent(job.manifest_key, record) && std::filesystem::exists(job.output, ec)) {
+                    up_to_date.fetch_add(1, std::memory_order_relaxed);
+                    line << "\"status\":\"up_to_date\"}";
+                    events.Emit(line.str());
+                    continue;
+                }
+
+                try {
+                    std::filesystem::create_directories(job.output.parent_path());
+                    const ConversionStats stats = converter.ConvertFile(job.input.string(), job.output.string());
+                    succeeded.fetch_add(1, std::memory_order_relaxed);
+                    if (tracked) {
+                        manifest->Record(job.manifest_key, record);
+                    }
+                    line << "\"status\":\"ok\",\"stats\":" << StatsJson(stats) << "}";
+                } catch (const std::exception& e) {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                    if (manifest != nullptr) {
+                        manifest->Forget(job.manifest_key);
+                    }
+                    line << "\"status\":\"error\",\"error\":\"" << JsonEscape(e.what()) << "\"}";
+                }
+                events.Emit(line.str());
+                if (manifest != nullptr) {
+                    try {
+                        manifest->Checkpoint(std::chrono::seconds(60));
+                    } catch (const std::exception&) {
+                        // Retried at the final save, which reports the error.
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    bool manifest_failed = false;
+    if (manifest != nullptr) {
+        try {
+            manifest->Save();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            manifest_failed = true;
+        }
+    }
+
+    const bool interrupted = g_sigint_received.load(std::memory_order_relaxed);
+    const int not_started = static_cast<int>(jobs.size()) - succeeded.load() - failed.load() - up_to_date.load();
+    events.Emit("{\"event\":\"summary\",\"total\":" + std::to_string(jobs.size()) +
+                ",\"ok\":" + std::to_string(succeeded.load()) +
+                ",\"failed\":" + std::to_string(failed.load()) +
+                ",\"up_to_date\":" + std::to_string(up_to_date.load()) +
+                ",\"not_started\":" + std::to_string(not_started) +
+                ",\"interrupted\":" + (interrupted ? "true" : "false") + "}");
+    if (interrupted) {
+        return kExitInterrupted;
+    }
+    return (failed.load() > 0 || manifest_failed) ? kExitFailures : kExitOk;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // Ctrl-C stops handing out new jobs; conversions already running finish first.
+    InitSigintHandler();
+
+    CliArgs args;
+    const int parse_status = ParseArgs(argc, argv, args);
+    if (parse_status >= 0) {
+        return parse_status;
+    }
+
+    ConverterConfig config;
+    std::error_code ec;
+    if (std::filesystem::exists(args.config_path, ec)) {
+        if (!config.LoadFromFile(args.config_path)) {
+            std::cerr << "Could not read config " << args.config_path << "\n";
+            return kExitUsage;
+        }
+    }
+
+    const int bitrate_bps = args.bitrate_kbps > 0 ? args.bitrate_kbps * 1000 : BitrateFromConfig(config);
+    ConverterOptions options = ConverterOptionsFromConfig(config);
+    if (!args.dedup_cache_dir.empty()) {
+        options.dedup_cache_dir = args.dedup_cache_dir;
+    }
+    if (args.stream_copy) {
+        options.stream_copy = true;
+    }
+    if (args.fast_open) {
+        options.fast_open = true;
+    }
+    ThreadBudget::Global().SetCapacity(args.threads > 0 ? args.threads : ThreadBudgetFromConfig(config));
+    OpusProfile profile;
+    SchedulingPolicy order;
+    try {
+        profile = OpusProfileFromConfig(config, args.profile);
+        order = SchedulingPolicyFromConfig(config, args.order);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return kExitUsage;
+    }
+
+    if (args.inputs.front() == "-") {
+        return RunStream(args, bitrate_bps, profile, options);
+    }
+    return RunBatch(args, config, bitrate_bps, profile, order, options);
+}
@@ -0,0 +1,198 @@
+#include "converter/AsyncFileWriter.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+namespace {
+constexpr int kAvioBufferSize = 64 * 1024;
+}
+
+AsyncFileWriter::AsyncFileWriter(const std::string& path, std::size_t buffer_bytes)
+    : fd_(-1),
+      buffer_bytes_(std::max<std::size_t>(buffer_bytes, kAvioBufferSize)),
+      avio_(nullptr),
+      position_(0),
+      end_(0),
+      writing_(false),
+      stop_(false),
+      error_(0) {
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Could not open output file: " + path);
+    }
+
+    unsigned char* buffer = static_cast<unsigned char*>(av_malloc(kAvioBufferSize));
+    if (buffer != nullptr) {
+        avio_ = avio_alloc_context(buffer, kAvioBufferSize, 1, this, nullptr, &AsyncFileWriter::Write, &AsyncFileWriter::Seek);
+    }
+    if (avio_ == nullptr) {
+        av_free(buffer);
+        ::close(fd_);
+        throw std::runtime_error("Could not allocate output AVIOContext");
+    }
+    avio_->seekable = AVIO_SEEKABLE_NORMAL;
+
+    active_.data.reserve(buffer_bytes_);
+    thread_ = std::thread(&AsyncFileWriter::WriterLoop, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    try {
+        Shutdown();
+    } catch (...) {
+    }
+    if (avio_ != nullptr) {
+        av_freep(&avio_->buffer);
+        avio_context_free(&avio_);
+    }
+}
+
+int AsyncFileWriter::Write(void* opaque, WriteBuffer buf, int buf_size) {
+    AsyncFileWriter* self = static_cast<AsyncFileWriter*>(opaque);
+    const uint8_t* src = buf;
+    std::size_t left = static_cast<std::size_t>(buf_size);
+    while (left > 0) {
+        const std::size_t room = self->buffer_bytes_ - self->active_.data.size();
+        const std::size_t count = std::min(room, left);
+        self->active_.data.insert(self->active_.data.end(), src, src + count);
+        src += count;
+        left -= count;
+        // Keep active_.offset + active_.data.size() == position_ so Submit can start the next chunk.
+        self->position_ += static_cast<int64_t>(count);
+        self->end_ = std::max(self->end_, self->position_);
+        if (self->active_.data.size() >= self->buffer_bytes_ && !self->Submit()) {
+            return AVERROR(EIO);
+        }
+    }
+    return buf_size;
+}
+
+int64_t AsyncFileWriter::Seek(void* opaque, int64_t offset, int whence) {
+    AsyncFileWriter* self = static_cast<AsyncFileWriter*>(opaque);
+    whence &= ~AVSEEK_FORCE;
+    int64_t target = 0;
+    switch (whence) {
+    case AVSEEK_SIZE:
+        return self->end_;
+    case SEEK_SET:
+        target = offset;
+        break;
+    case SEEK_CUR:
+        target = self->position_ + offset;
+        break;
+    case SEEK_END:
+        target = self->end_ + offset;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (target < 0) {
+        return AVERROR(EINVAL);
+    }
+    // Chunks carry their own offset, so a seek just starts a new chunk at the target.
+    if (target != self->position_) {
+        self->position_ = target;
+        if (!self->Submit()) {
+            return AVERROR(EIO);
+        }
+    }
+    return target;
+}
+
+bool AsyncFileWriter::Submit() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!active_.data.empty()) {
+        // Bounded memory: at most one chunk queued behind the one being written.
+        cv_.wait(lock, [this]() { return pending_.empty() || error_ != 0; });
+        if (error_ == 0) {
+            pending_.push_back(std::move(active_));
+            cv_.notify_all();
+        }
+        if (!spare_.empty()) {
+            active_ = std::move(spare_.back());
+            spare_.pop_back();
+        } else {
+            active_ = Chunk{};
+            active_.data.reserve(buffer_bytes_);
+        }
+        active_.data.clear();
+    }
+    active_.offset = position_;
+    return error_ == 0;
+}
+
+void AsyncFileWriter::WriterLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this]() { return !pending_.empty() || stop_; });
+        if (pending_.empty()) {
+            return;
+        }
+        Chunk chunk = std::move(pending_.front());
+        pending_.pop_front();
+        writing_ = true;
+        lock.unlock();
+
+        int error = 0;
+        std::size_t done = 0;
+        while (done < chunk.data.size()) {
+            const ssize_t n = ::pwrite(fd_, chunk.data.data() + done, chunk.data.size() - done,
+                                       static_cast<off_t>(chunk.offset + static_cast<int64_t>(done)));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                error = errno;
+                break;
+            }
+            done += static_cast<std::size_t>(n);
+        }
+
+        lock.lock();
+        writing_ = false;
+        if (error != 0 && error_ == 0) {
+            error_ = error;
+        }
+        spare_.push_back(std::move(chunk));
+        cv_.notify_all();
+    }
+}
+
+void AsyncFileWriter::Shutdown() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    avio_flush(avio_);
+    Submit();
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return (pending_.empty() && !writing_) || error_ != 0; });
+        stop_ = true;
+        pending_.clear();
+        cv_.notify_all();
+    }
+    thread_.join();
+    if (fd_ >= 0) {
+        if (::close(fd_) != 0 && error_ == 0) {
+            error_ = errno;
+        }
+        fd_ = -1;
+    }
+}
+
+void AsyncFileWriter::Close() {
+    Shutdown();
+    if (error_ != 0) {
+        throw std::runtime_error(std::string("Output write failed: ") + std::strerror(error_));
+    }
+}
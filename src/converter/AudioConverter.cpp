@@ -1,16 +1,161 @@
 #include "converter/AudioConverter.hpp"
+#include "converter/AsyncFileWriter.hpp"
+#include "converter/ConversionManifest.hpp"
+#include "converter/DedupCache.hpp"
+#include "converter/FdStream.hpp"
+#include "converter/MappedInput.hpp"
+#include "converter/ProgressRecord.hpp"
+#include "converter/SampleRingBuffer.hpp"
+#include "converter/SpscQueue.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <filesystem>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
+#include <sys/stat.h>
+
 extern "C" {
 #include <libavutil/opt.h>
-#include <libavutil/audio_fifo.h>
 }
 
+namespace {
+// Blocking FIFO with a fixed capacity; Push waits while full, Pop waits while empty and not closed.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) : capacity_(std::max<std::size_t>(1, capacity)) {}
+
+    void Push(T value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]() { return items_.size() < capacity_ || closed_; });
+        if (closed_) {
+            return;
+        }
+        items_.push_back(std::move(value));
+        not_empty_.notify_one();
+    }
+
+    bool Pop(T& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return !items_.empty() || closed_; });
+        if (items_.empty()) {
+            return false;
+        }
+        out = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    // Wakes all waiters; remaining items are still handed out by Pop.
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+    std::size_t capacity_;
+    std::deque<T> items_;
+    bool closed_ = false;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+// Spin briefly, then yield, then sleep: keeps hand-off latency low without burning a core
+// while a stage waits on a slower neighbour. Returns false once abort is raised.
+template <typename Wait>
+bool Backoff(int& attempt, const std::atomic<bool>& abort, Wait&& ready) {
+    while (!ready()) {
+        if (abort.load(std::memory_order_acquire)) {
+            return false;
+        }
+        ++attempt;
+        if (attempt < 64) {
+            continue;
+        }
+        if (attempt < 256) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+    return true;
+}
+
+template <typename T>
+bool PushWait(SpscQueue<T>& queue, const T& value, const std::atomic<bool>& abort) {
+    int attempt = 0;
+    return Backoff(attempt, abort, [&]() { return queue.TryPush(value); });
+}
+
+template <typename T>
+bool PopWait(SpscQueue<T>& queue, T& out, const std::atomic<bool>& abort) {
+    int attempt = 0;
+    return Backoff(attempt, abort, [&]() { return queue.TryPop(out); });
+}
+
+// Demuxer that fast_open uses for an input extension instead of probing.
+const char* DemuxerForExtension(const std::string& extension) {
+    static const std::pair<const char*, const char*> kDemuxers[] = {
+        {".mp3", "mp3"},
+        {".opus", "ogg"},
+        {".ogg", "ogg"},
+        {".flac", "flac"},
+        {".wav", "wav"},
+    };
+    for (const auto& entry : kDemuxers) {
+        if (extension == entry.first) {
+            return entry.second;
+        }
+    }
+    return nullptr;
+}
+
+// Incremental runs rewrite the manifest at most this often while converting, and once at the end.
+constexpr std::chrono::seconds kManifestCheckpointInterval(60);
+
+std::unique_ptr<ConversionManifest> LoadManifest(bool incremental, const std::string& output_dir) {
+    if (!incremental) {
+        return nullptr;
+    }
+    auto manifest = std::make_unique<ConversionManifest>(ConversionManifest::PathFor(output_dir));
+    manifest->Load();
+    return manifest;
+}
+
+int64_t ElapsedNs(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Adds the lifetime of the scope to one of the stage counters.
+class StageTimer {
+public:
+    explicit StageTimer(std::atomic<int64_t>& counter)
+        : counter_(counter),
+          start_(std::chrono::steady_clock::now()) {}
+    ~StageTimer() { StatsCollector::Add(counter_, ElapsedNs(start_)); }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    std::atomic<int64_t>& counter_;
+    std::chrono::steady_clock::time_point start_;
+};
+} // namespace
+
 AudioConverter::AudioConverter(int bitrate)
     : bitrate_bps_(bitrate),
       input_ctx_(nullptr),
@@ -18,7 +163,17 @@ AudioConverter::AudioConverter(int bitrate)
       input_codec_ctx_(nullptr),
       output_codec_ctx_(nullptr),
       resample_ctx_(nullptr),
-      audio_stream_index_(-1) {
+      sample_path_(SamplePath::Resample),
+      audio_stream_index_(-1),
+      hot_loop_allocations_(0),
+      expected_input_bytes_(0),
+      stats_interval_(500),
+      progress_interval_(100),
+      progress_record_(nullptr),
+      progress_file_id_(0),
+      pipeline_granted_(false),
+      codec_extra_threads_(0),
+      resampler_ready_(false) {
     InitLibav();
 }
 
@@ -30,38 +185,143 @@ void AudioConverter::InitLibav() {
     avformat_network_init();
 }
 
+ThreadBudget::Lease AudioConverter::LeaseThreads() {
+    // Ask for every stage thread the options could use plus the requested codec threads, then
+    // fit the conversion into whatever was granted (always at least this thread).
+    int stage_threads = options_.pipelined ? 3 : 1;
+    if (options_.segments.count > 1) {
+        stage_threads = std::max(stage_threads, options_.segments.count);
+    }
+    ThreadBudget::Lease lease = ThreadBudget::Global().Acquire(stage_threads + std::max(0, options_.codec_threads));
+    // Pipelining needs all three stages at once; with fewer threads the loop runs inline.
+    pipeline_granted_ = options_.pipelined && lease.Threads() >= 3;
+    const int used = pipeline_granted_ ? 3 : 1;
+    codec_extra_threads_ = std::max(0, std::min(options_.codec_threads, lease.Threads() - used));
+    return lease;
+}
+
+void AudioConverter::AttachInputIO(AVIOContext* io) {
+    input_ctx_ = avformat_alloc_context();
+    if (input_ctx_ == nullptr) {
+        throw std::runtime_error("Failed to allocate input format context");
+    }
+    input_ctx_->pb = io;
+    input_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+}
+
 void AudioConverter::OpenInputFile(const std::string& input_path) {
-    if (avformat_open_input(&input_ctx_, input_path.c_str(), nullptr, nullptr) < 0) {
-        throw std::runtime_error("Could not open input file: " + input_path);
+    if (stream_input_ != nullptr) {
+        AttachInputIO(stream_input_->Context());
+    } else if (options_.mmap_input) {
+        mapped_input_ = std::make_unique<MappedInput>(input_path);
+        AttachInputIO(mapped_input_->Context());
     }
 
-    if (avformat_find_stream_info(input_ctx_, nullptr) < 0) {
-        throw std::runtime_error("Could not find stream information");
+    const AVInputFormat* input_format = nullptr;
+    if (options_.fast_open) {
+        const char* demuxer = DemuxerForExtension(std::filesystem::path(input_path).extension().string());
+        if (demuxer != nullptr) {
+            input_format = av_find_input_format(demuxer);
+        }
+    }
+    AVDictionary* open_options = nullptr;
+    if (options_.probe_size_bytes > 0) {
+        av_dict_set_int(&open_options, "probesize", options_.probe_size_bytes, 0);
+    }
+    if (options_.analyze_duration_us > 0) {
+        av_dict_set_int(&open_options, "analyzeduration", options_.analyze_duration_us, 0);
+    }
+    const int opened = avformat_open_input(&input_ctx_, input_path.c_str(), input_format, &open_options);
+    av_dict_free(&open_options);
+    if (opened < 0) {
+        throw std::runtime_error("Could not open input file: " + input_path);
     }
 
+    // Stream info needs decoding; fast_open skips it when the header already said enough.
     audio_stream_index_ = av_find_best_stream(input_ctx_, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (!options_.fast_open || audio_stream_index_ < 0 || !InputParametersKnown()) {
+        if (avformat_find_stream_info(input_ctx_, nullptr) < 0) {
+            throw std::runtime_error("Could not find stream information");
+        }
+        audio_stream_index_ = av_find_best_stream(input_ctx_, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    }
     if (audio_stream_index_ < 0) {
         throw std::runtime_error("No audio stream found in " + input_path);
     }
+    if (!InputParametersKnown()) {
+        throw std::runtime_error("Could not determine the audio format of " + input_path + " within the probe limits");
+    }
 
-    const AVCodec* input_codec = avcodec_find_decoder(input_ctx_->streams[audio_stream_index_]->codecpar->codec_id);
+    const AVCodecParameters* par = input_ctx_->streams[audio_stream_index_]->codecpar;
+    if (input_codec_ctx_ != nullptr) {
+        if (CanReuseDecoder(*par)) {
+            // Same stream parameters as the last file: reset the open codecs instead of rebuilding.
+            avcodec_flush_buffers(input_codec_ctx_);
+            return;
+        }
+        ReleaseCodecs();
+    }
+
+    const AVCodec* input_codec = avcodec_find_decoder(par->codec_id);
     input_codec_ctx_ = avcodec_alloc_context3(input_codec);
     if (input_codec_ctx_ == nullptr) {
         throw std::runtime_error("Failed to allocate input codec context");
     }
+    // An explicit count keeps libavcodec from sizing its own pool to every core; the extra
+    // threads granted by the budget are split between decoder and encoder.
+    input_codec_ctx_->thread_count = 1 + codec_extra_threads_ / 2;
+    input_codec_ctx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 
-    avcodec_parameters_to_context(input_codec_ctx_, input_ctx_->streams[audio_stream_index_]->codecpar);
+    avcodec_parameters_to_context(input_codec_ctx_, par);
     if (avcodec_open2(input_codec_ctx_, input_codec, nullptr) < 0) {
         throw std::runtime_error("Could not open input codec");
     }
 }
 
-void AudioConverter::SetupOutputFile(const std::string& output_path) {
+bool AudioConverter::CanReuseDecoder(const AVCodecParameters& par) const {
+    if (!options_.reuse_codecs ||
+        input_codec_ctx_->codec_id != par.codec_id ||
+        input_codec_ctx_->sample_rate != par.sample_rate ||
+        av_channel_layout_compare(&input_codec_ctx_->ch_layout, &par.ch_layout) != 0 ||
+        input_codec_ctx_->thread_count != 1 + codec_extra_threads_ / 2) {
+        return false;
+    }
+    if (input_codec_ctx_->extradata_size != par.extradata_size) {
+        return false;
+    }
+    return par.extradata_size == 0 || std::memcmp(input_codec_ctx_->extradata, par.extradata, par.extradata_size) == 0;
+}
+
+bool AudioConverter::InputParametersKnown() const {
+    const AVCodecParameters* par = input_ctx_->streams[audio_stream_index_]->codecpar;
+    return par->codec_id != AV_CODEC_ID_NONE && par->sample_rate > 0 && par->ch_layout.nb_channels > 0;
+}
+
+void AudioConverter::OpenEncoder() {
+    const int thread_count = 1 + codec_extra_threads_ - codec_extra_threads_ / 2;
+    // An encoder kept from the last file (reuse_codecs) is held until its replacement is open,
+    // to tell whether the resampler still fits.
+    std::unique_ptr<AVCodecContext, void (*)(AVCodecContext*)> previous(
+        nullptr, [](AVCodecContext* ctx) { avcodec_free_context(&ctx); });
+    if (output_codec_ctx_ != nullptr) {
+        // It was configured for the same input parameters as this file. Only encoders that
+        // support flushing can start a new stream without being reopened; libopus cannot.
+        const bool flushable = (output_codec_ctx_->codec->capabilities & AV_CODEC_CAP_ENCODER_FLUSH) != 0;
+        if (flushable && output_codec_ctx_->thread_count == thread_count) {
+            avcodec_flush_buffers(output_codec_ctx_);
+            return;
+        }
+        previous.reset(output_codec_ctx_);
+        output_codec_ctx_ = nullptr;
+    }
+
     const AVCodec* output_codec = avcodec_find_encoder(OutputCodecId());
     output_codec_ctx_ = avcodec_alloc_context3(output_codec);
     if (output_codec_ctx_ == nullptr) {
         throw std::runtime_error("Failed to allocate output codec context");
     }
+    output_codec_ctx_->thread_count = thread_count;
+    output_codec_ctx_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 
     ConfigureOutputCodecContext(*output_codec_ctx_, *input_codec_ctx_);
 
@@ -69,6 +329,18 @@ void AudioConverter::SetupOutputFile(const std::string& output_path) {
         throw std::runtime_error("Could not open output codec");
     }
 
+    if (previous != nullptr && resampler_ready_) {
+        resampler_ready_ = previous->sample_rate == output_codec_ctx_->sample_rate &&
+                           previous->sample_fmt == output_codec_ctx_->sample_fmt &&
+                           av_channel_layout_compare(&previous->ch_layout, &output_codec_ctx_->ch_layout) == 0;
+    }
+}
+
+void AudioConverter::SetupOutputFile(const std::string& output_path, bool stream_copy) {
+    if (!stream_copy) {
+        OpenEncoder();
+    }
+
     output_ctx_ = avformat_alloc_context();
     const std::string container = PreferredContainer(output_path);
     output_ctx_->oformat = av_guess_format(container.c_str(), output_path.c_str(), nullptr);
@@ -79,7 +351,16 @@ void AudioConverter::SetupOutputFile(const std::string& output_path) {
         throw std::runtime_error("Could not find suitable output format");
     }
 
-    if (avio_open(&output_ctx_->pb, output_path.c_str(), AVIO_FLAG_WRITE) < 0) {
+    if (stream_output_ != nullptr) {
+        output_ctx_->pb = stream_output_->Context();
+        output_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+        // Push every muxed page to the consumer immediately instead of filling the AVIO buffer.
+        output_ctx_->flush_packets = 1;
+    } else if (options_.output_buffer_bytes > 0) {
+        output_writer_ = std::make_unique<AsyncFileWriter>(output_path, options_.output_buffer_bytes);
+        output_ctx_->pb = output_writer_->Context();
+        output_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+    } else if (avio_open(&output_ctx_->pb, output_path.c_str(), AVIO_FLAG_WRITE) < 0) {
         throw std::runtime_error("Could not open output file");
     }
 
@@ -88,9 +369,21 @@ void AudioConverter::SetupOutputFile(const std::string& output_path) {
         throw std::runtime_error("Could not create output stream");
     }
 
-    output_stream->time_base = {1, output_codec_ctx_->sample_rate};
-    if (avcodec_parameters_from_context(output_stream->codecpar, output_codec_ctx_) < 0) {
-        throw std::runtime_error("Failed to copy codec parameters");
+    if (stream_copy) {
+        const AVStream* input_stream = input_ctx_->streams[audio_stream_index_];
+        if (avcodec_parameters_copy(output_stream->codecpar, input_stream->codecpar) < 0) {
+            throw std::runtime_error("Failed to copy codec parameters");
+        }
+        // The input container's tag may mean nothing (or something else) in the output one.
+        output_stream->codecpar->codec_tag = 0;
+        output_stream->time_base = input_stream->time_base;
+        // Ogg keeps tags such as Vorbis comments on the stream rather than the container.
+        av_dict_copy(&output_stream->metadata, input_stream->metadata, 0);
+    } else {
+        output_stream->time_base = {1, output_codec_ctx_->sample_rate};
+        if (avcodec_parameters_from_context(output_stream->codecpar, output_codec_ctx_) < 0) {
+            throw std::runtime_error("Failed to copy codec parameters");
+        }
     }
 
     if (input_ctx_->metadata != nullptr) {
@@ -103,6 +396,28 @@ void AudioConverter::SetupOutputFile(const std::string& output_path) {
 }
 
 void AudioConverter::SetupResampler() {
+    if (resampler_ready_) {
+        // Decoder and encoder are unchanged; re-initialising drops the last file's buffered tail.
+        if (resample_ctx_ != nullptr && swr_init(resample_ctx_) < 0) {
+            throw std::runtime_error("Could not initialize resampler");
+        }
+        return;
+    }
+    if (resample_ctx_ != nullptr) {
+        swr_free(&resample_ctx_);
+    }
+
+    const AVSampleFormat in_fmt = input_codec_ctx_->sample_fmt;
+    const AVSampleFormat out_fmt = output_codec_ctx_->sample_fmt;
+    if (input_codec_ctx_->sample_rate == output_codec_ctx_->sample_rate &&
+        av_channel_layout_compare(&input_codec_ctx_->ch_layout, &output_codec_ctx_->ch_layout) == 0 &&
+        SampleRingBuffer::CanConvert(in_fmt, out_fmt, output_codec_ctx_->ch_layout.nb_channels)) {
+        sample_path_ = in_fmt == out_fmt ? SamplePath::Passthrough : SamplePath::Convert;
+        resampler_ready_ = true;
+        return;
+    }
+
+    sample_path_ = SamplePath::Resample;
     resample_ctx_ = swr_alloc();
     if (resample_ctx_ == nullptr) {
         throw std::runtime_error("Could not allocate resample context");
@@ -118,6 +433,7 @@ void AudioConverter::SetupResampler() {
     if (swr_init(resample_ctx_) < 0) {
         throw std::runtime_error("Could not initialize resampler");
     }
+    resampler_ready_ = true;
 }
 
 int AudioConverter::TargetFrameSize(const AVCodecContext& output_ctx) const {
@@ -131,197 +447,600 @@ bool AudioConverter::ShouldConvertFile(const std::string& extension) const {
     return extension == ".mp3";
 }
 
-void AudioConverter::ConvertAudio() {
-    AVPacket* input_packet = av_packet_alloc();
-    AVPacket* output_packet = av_packet_alloc();
-    AVFrame* input_frame = av_frame_alloc();
-    AVFrame* resampled_frame = av_frame_alloc();
-    AVFrame* output_frame = av_frame_alloc();
+bool AudioConverter::CanStreamCopy(const AVCodecParameters& input, int64_t input_bitrate) const {
+    if (input.codec_id != OutputCodecId()) {
+        return false;
+    }
+    const int tolerance = options_.stream_copy_tolerance_percent;
+    if (tolerance < 0) {
+        return true;
+    }
+    if (input_bitrate <= 0) {
+        return false;
+    }
+    const int64_t difference = input_bitrate > bitrate_bps_ ? input_bitrate - bitrate_bps_ : bitrate_bps_ - input_bitrate;
+    return difference * 100 <= static_cast<int64_t>(tolerance) * bitrate_bps_;
+}
 
-    const int frame_size = TargetFrameSize(*output_codec_ctx_);
+bool AudioConverter::StreamCopyApplies() const {
+    if (!options_.stream_copy) {
+        return false;
+    }
+    const AVStream* stream = input_ctx_->streams[audio_stream_index_];
+    // Ogg rarely records a stream bitrate; the container estimate from size and duration is
+    // close enough for the tolerance check.
+    const int64_t bitrate = stream->codecpar->bit_rate > 0 ? stream->codecpar->bit_rate : input_ctx_->bit_rate;
+    return CanStreamCopy(*stream->codecpar, bitrate);
+}
 
-    AVAudioFifo* fifo = av_audio_fifo_alloc(
-        output_codec_ctx_->sample_fmt,
-        output_codec_ctx_->ch_layout.nb_channels,
-        1
-    );
+std::string AudioConverter::ConfigFingerprint() const {
+    std::string fingerprint = avcodec_get_name(OutputCodecId());
+    fingerprint += ";container=" + PreferredContainer("");
+    fingerprint += ";bitrate=" + std::to_string(bitrate_bps_);
+    if (options_.stream_copy) {
+        fingerprint += ";stream_copy=" + std::to_string(options_.stream_copy_tolerance_percent);
+    }
+    return fingerprint;
+}
+
+bool AudioConverter::AcceptsInput(const std::string& input_path) const {
+    return ShouldConvertFile(std::filesystem::path(input_path).extension().string());
+}
+
+bool AudioConverter::SameFile(const std::string& a, const std::string& b) {
+    std::error_code ec;
+    return std::filesystem::equivalent(a, b, ec) && !ec;
+}
 
-    if (fifo == nullptr) {
-        throw std::runtime_error("Could not allocate FIFO");
+void AudioConverter::AllocateAudioFrame(AVFrame* frame, int nb_samples) {
+    av_frame_unref(frame);
+    frame->nb_samples = nb_samples;
+    frame->sample_rate = output_codec_ctx_->sample_rate;
+    frame->format = output_codec_ctx_->sample_fmt;
+    if (av_channel_layout_copy(&frame->ch_layout, &output_codec_ctx_->ch_layout) < 0) {
+        throw std::runtime_error("Could not copy channel layout");
     }
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        throw std::runtime_error("Could not allocate frame buffer");
+    }
+}
 
-    int64_t pts = 0;
-    int frame_count = 0;
-    int64_t processed_samples = 0;
-    int64_t expected_samples = 0;
+int64_t AudioConverter::ExpectedOutputSamples() const {
     if (input_ctx_ != nullptr && input_ctx_->duration > 0 && output_codec_ctx_ != nullptr) {
         const double duration_seconds = static_cast<double>(input_ctx_->duration) / AV_TIME_BASE;
-        expected_samples = static_cast<int64_t>(duration_seconds * output_codec_ctx_->sample_rate);
+        return static_cast<int64_t>(duration_seconds * output_codec_ctx_->sample_rate);
     }
+    // Without avformat_find_stream_info (fast_open) only the demuxer's stream duration is set.
+    if (input_ctx_ != nullptr && output_codec_ctx_ != nullptr && audio_stream_index_ >= 0) {
+        const AVStream* stream = input_ctx_->streams[audio_stream_index_];
+        if (stream->duration > 0) {
+            return av_rescale_q(stream->duration, stream->time_base, AVRational{1, output_codec_ctx_->sample_rate});
+        }
+    }
+    return 0;
+}
 
-    while (av_read_frame(input_ctx_, input_packet) >= 0) {
-        if (input_packet->stream_index == audio_stream_index_) {
-            if (avcodec_send_packet(input_codec_ctx_, input_packet) < 0) {
-                throw std::runtime_error("Failed to send packet to decoder");
-            }
+int AudioConverter::InitialResampledCapacity() const {
+    // MP3 decoders report their fixed frame size; otherwise assume a generous default and let
+    // the loop grow the buffer (counted) if a larger frame shows up.
+    const int input_frame_samples = input_codec_ctx_->frame_size > 0 ? input_codec_ctx_->frame_size : 4096;
+    return static_cast<int>(av_rescale_rnd(
+        input_frame_samples + 64,
+        output_codec_ctx_->sample_rate,
+        input_codec_ctx_->sample_rate,
+        AV_ROUND_UP
+    ));
+}
 
-            while (avcodec_receive_frame(input_codec_ctx_, input_frame) >= 0) {
-                resampled_frame->sample_rate = output_codec_ctx_->sample_rate;
-                resampled_frame->format = output_codec_ctx_->sample_fmt;
-                av_channel_layout_copy(&resampled_frame->ch_layout, &output_codec_ctx_->ch_layout);
-                resampled_frame->nb_samples = av_rescale_rnd(
-                    swr_get_delay(resample_ctx_, input_codec_ctx_->sample_rate) + input_frame->nb_samples,
-                    output_codec_ctx_->sample_rate,
-                    input_codec_ctx_->sample_rate,
-                    AV_ROUND_UP
-                );
-
-                if (av_frame_get_buffer(resampled_frame, 0) < 0) {
-                    throw std::runtime_error("Could not allocate resampled frame buffer");
-                }
+int AudioConverter::ResampleIntoFifo(AVFrame* input_frame,
+                                     AVFrame* resampled_frame,
+                                     int& resampled_capacity,
+                                     SampleRingBuffer& fifo,
+                                     int64_t& allocations) {
+    if (sample_path_ != SamplePath::Resample) {
+        // Decoders may switch parameters mid-stream; the bypass only holds for the opened format.
+        if (input_frame->format != input_codec_ctx_->sample_fmt ||
+            input_frame->sample_rate != input_codec_ctx_->sample_rate ||
+            input_frame->ch_layout.nb_channels != input_codec_ctx_->ch_layout.nb_channels) {
+            throw std::runtime_error("Input sample format changed mid-stream");
+        }
+        const int samples = input_frame->nb_samples;
+        if (fifo.Space() < samples && fifo.Reserve(fifo.Size() + samples)) {
+            ++allocations;
+        }
+        StageTimer timer(stats_.resample_ns);
+        const uint8_t* const* input_data = input_frame->extended_data;
+        if (!fifo.WriteConverted(input_data, samples, input_codec_ctx_->sample_fmt)) {
+            throw std::runtime_error("Could not write to FIFO");
+        }
+        stats_.RaisePeakFifo(fifo.Size());
+        return samples;
+    }
 
-                const uint8_t** input_data = const_cast<const uint8_t**>(input_frame->data);
-                int converted = swr_convert(
-                    resample_ctx_,
-                    resampled_frame->data, resampled_frame->nb_samples,
-                    input_data, input_frame->nb_samples
-                );
+    const int required = static_cast<int>(av_rescale_rnd(
+        swr_get_delay(resample_ctx_, input_codec_ctx_->sample_rate) + input_frame->nb_samples,
+        output_codec_ctx_->sample_rate,
+        input_codec_ctx_->sample_rate,
+        AV_ROUND_UP
+    ));
+    if (required > resampled_capacity) {
+        resampled_capacity = required;
+        AllocateAudioFrame(resampled_frame, resampled_capacity);
+        ++allocations;
+    }
 
-                if (converted < 0) {
-                    throw std::runtime_error("Resampling failed");
-                }
+    StageTimer timer(stats_.resample_ns);
+    const uint8_t** input_data = const_cast<const uint8_t**>(input_frame->data);
+    int converted = swr_convert(
+        resample_ctx_,
+        resampled_frame->data, resampled_capacity,
+        input_data, input_frame->nb_samples
+    );
 
-                resampled_frame->nb_samples = converted;
+    if (converted < 0) {
+        throw std::runtime_error("Resampling failed");
+    }
 
-                if (av_audio_fifo_realloc(fifo, av_audio_fifo_size(fifo) + converted) < 0) {
-                    throw std::runtime_error("Could not realloc FIFO");
-                }
+    if (fifo.Space() < converted && fifo.Reserve(fifo.Size() + converted)) {
+        ++allocations;
+    }
 
-                if (av_audio_fifo_write(fifo, reinterpret_cast<void**>(resampled_frame->data), converted) < converted) {
-                    throw std::runtime_error("Could not write to FIFO");
-                }
+    if (!fifo.Write(resampled_frame->data, converted)) {
+        throw std::runtime_error("Could not write to FIFO");
+    }
+    stats_.RaisePeakFifo(fifo.Size());
+    return converted;
+}
 
-                while (av_audio_fifo_size(fifo) >= frame_size) {
-                    output_frame->nb_samples = frame_size;
-                    output_frame->sample_rate = output_codec_ctx_->sample_rate;
-                    output_frame->format = output_codec_ctx_->sample_fmt;
-                    av_channel_layout_copy(&output_frame->ch_layout, &output_codec_ctx_->ch_layout);
+void AudioConverter::FillOutputFrame(AVFrame* output_frame, SampleRingBuffer& fifo, int nb_samples, int64_t& allocations) {
+    // The encoder drops its reference once the packet is drained, so this is a no-op in steady
+    // state; any buffer it does have to replace is counted.
+    uint8_t* const before = output_frame->data[0];
+    if (av_frame_make_writable(output_frame) < 0) {
+        throw std::runtime_error("Could not make output frame writable");
+    }
+    if (output_frame->data[0] != before) {
+        ++allocations;
+    }
+    output_frame->nb_samples = nb_samples;
+    if (!fifo.Read(output_frame->data, nb_samples)) {
+        throw std::runtime_error("FIFO read failed");
+    }
+}
 
-                    if (av_frame_get_buffer(output_frame, 0) < 0) {
-                        throw std::runtime_error("Could not allocate output frame buffer");
-                    }
+void AudioConverter::EncodeAndWrite(AVFrame* frame, AVPacket* packet) {
+    if (SendToEncoder(frame) < 0) {
+        if (frame == nullptr) {
+            return;
+        }
+        throw std::runtime_error("Encoder send failed");
+    }
 
-                    if (av_audio_fifo_read(fifo, reinterpret_cast<void**>(output_frame->data), frame_size) < frame_size) {
-                        throw std::runtime_error("FIFO read failed");
-                    }
+    while (ReceiveEncoded(packet) == 0) {
+        packet->stream_index = 0;
+        WritePacket(packet);
+        av_packet_unref(packet);
+    }
+}
 
-                    output_frame->pts = pts;
-                    pts += frame_size;
-                    processed_samples += frame_size;
+int AudioConverter::ReadPacket(AVPacket* packet) {
+    StageTimer timer(stats_.demux_ns);
+    return av_read_frame(input_ctx_, packet);
+}
 
-                    if (avcodec_send_frame(output_codec_ctx_, output_frame) < 0) {
-                        throw std::runtime_error("Encoder send failed");
-                    }
+int AudioConverter::SendToDecoder(AVPacket* packet) {
+    StageTimer timer(stats_.decode_ns);
+    StatsCollector::Add(stats_.packets_read, 1);
+    return avcodec_send_packet(input_codec_ctx_, packet);
+}
 
-                    while (avcodec_receive_packet(output_codec_ctx_, output_packet) == 0) {
-                        output_packet->stream_index = 0;
-                        av_write_frame(output_ctx_, output_packet);
-                        av_packet_unref(output_packet);
-                        frame_count++;
-                    }
+int AudioConverter::ReceiveDecoded(AVFrame* frame) {
+    StageTimer timer(stats_.decode_ns);
+    const int ret = avcodec_receive_frame(input_codec_ctx_, frame);
+    if (ret >= 0) {
+        StatsCollector::Add(stats_.frames_decoded, 1);
+    }
+    return ret;
+}
 
-                    av_frame_unref(output_frame);
+int AudioConverter::SendToEncoder(AVFrame* frame) {
+    StageTimer timer(stats_.encode_ns);
+    const int ret = avcodec_send_frame(output_codec_ctx_, frame);
+    if (ret >= 0 && frame != nullptr) {
+        StatsCollector::Add(stats_.frames_encoded, 1);
+        StatsCollector::Add(stats_.samples_encoded, frame->nb_samples);
+    }
+    return ret;
+}
 
-                    if (progress_cb_ && expected_samples > 0) {
-                        double progress = static_cast<double>(processed_samples) / static_cast<double>(expected_samples);
-                        if (progress > 1.0) {
-                            progress = 1.0;
-                        }
-                        progress_cb_(progress);
-                    }
-                }
+int AudioConverter::ReceiveEncoded(AVPacket* packet) {
+    StageTimer timer(stats_.encode_ns);
+    return avcodec_receive_packet(output_codec_ctx_, packet);
+}
 
-                av_frame_unref(resampled_frame);
-            }
-        }
+void AudioConverter::WritePacket(AVPacket* packet) {
+    StageTimer timer(stats_.mux_ns);
+    StatsCollector::Add(stats_.packets_written, 1);
+    av_write_frame(output_ctx_, packet);
+}
 
-        av_packet_unref(input_packet);
+void AudioConverter::WriteTrailer() {
+    StageTimer timer(stats_.mux_ns);
+    av_write_trailer(output_ctx_);
+}
+
+void AudioConverter::BeginStats() {
+    stats_.Reset();
+    stats_started_ = std::chrono::steady_clock::now();
+    last_stats_report_ = stats_started_;
+    last_progress_report_ = std::chrono::steady_clock::time_point();
+    ++progress_file_id_;
+    if (progress_record_ != nullptr) {
+        progress_record_->Publish(0, 0, progress_file_id_);
     }
+}
 
-    while (av_audio_fifo_size(fifo) > 0) {
-        int remaining = std::min(av_audio_fifo_size(fifo), frame_size);
+ConversionStats AudioConverter::FinishStats() {
+    if (input_ctx_ != nullptr && input_ctx_->pb != nullptr) {
+        StatsCollector::Add(stats_.bytes_read, input_ctx_->pb->bytes_read);
+    }
+    if (output_ctx_ != nullptr && output_ctx_->pb != nullptr) {
+        StatsCollector::Add(stats_.bytes_written, avio_tell(output_ctx_->pb));
+    }
+    stats_.wall_ns.store(ElapsedNs(stats_started_), std::memory_order_relaxed);
+    return stats_.Snapshot();
+}
 
-        output_frame->nb_samples = remaining;
-        output_frame->sample_rate = output_codec_ctx_->sample_rate;
-        output_frame->format = output_codec_ctx_->sample_fmt;
-        av_channel_layout_copy(&output_frame->ch_layout, &output_codec_ctx_->ch_layout);
+void AudioConverter::ReportProgress(int64_t processed_samples, int64_t expected_samples) {
+    if (!stats_cb_ && !progress_cb_ && progress_record_ == nullptr) {
+        return;
+    }
+    int64_t done = processed_samples;
+    int64_t expected = expected_samples;
+    if (expected <= 0 && stream_input_ != nullptr && expected_input_bytes_ > 0) {
+        // Streams rarely carry a duration; fall back to the share of input consumed.
+        done = stream_input_->BytesTransferred();
+        expected = expected_input_bytes_;
+    }
+    if (progress_record_ != nullptr) {
+        progress_record_->Publish(done, expected, progress_file_id_);
+    }
+    if (!stats_cb_ && !progress_cb_) {
+        return;
+    }
 
-        if (av_frame_get_buffer(output_frame, 0) < 0) {
-            throw std::runtime_error("Could not allocate final frame buffer");
-        }
+    // Callbacks are rate limited so a fast encoder does not hand every 20 ms frame to the caller.
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (stats_cb_ && now - last_stats_report_ >= stats_interval_) {
+        last_stats_report_ = now;
+        ConversionStats snapshot = stats_.Snapshot();
+        snapshot.wall_ns = ElapsedNs(stats_started_);
+        stats_cb_(snapshot);
+    }
+    if (!progress_cb_ || expected <= 0 || now - last_progress_report_ < progress_interval_) {
+        return;
+    }
+    last_progress_report_ = now;
+    double progress = static_cast<double>(done) / static_cast<double>(expected);
+    if (progress > 1.0) {
+        progress = 1.0;
+    }
+    progress_cb_(progress);
+}
 
-        if (av_audio_fifo_read(fifo, reinterpret_cast<void**>(output_frame->data), remaining) < remaining) {
-            throw std::runtime_error("Failed to read from FIFO");
-        }
+void AudioConverter::ReportProgressComplete() {
+    if (progress_record_ != nullptr) {
+        progress_record_->Complete();
+    }
+    if (progress_cb_) {
+        progress_cb_(1.0);
+    }
+}
 
-        output_frame->pts = pts;
-        pts += remaining;
-        processed_samples += remaining;
+void AudioConverter::RemuxAudio() {
+    AVPacket* packet = av_packet_alloc();
+    const AVStream* input_stream = input_ctx_->streams[audio_stream_index_];
+    const AVRational output_time_base = output_ctx_->streams[0]->time_base;
 
-        if (avcodec_send_frame(output_codec_ctx_, output_frame) < 0) {
-            throw std::runtime_error("Failed to flush frame");
-        }
+    // Progress is measured in the input stream's time base.
+    const int64_t start = input_stream->start_time != AV_NOPTS_VALUE ? input_stream->start_time : 0;
+    int64_t expected = input_stream->duration > 0 ? input_stream->duration : 0;
+    if (expected <= 0 && input_ctx_->duration > 0) {
+        expected = av_rescale_q(input_ctx_->duration, av_get_time_base_q(), input_stream->time_base);
+    }
 
-        while (avcodec_receive_packet(output_codec_ctx_, output_packet) == 0) {
-            output_packet->stream_index = 0;
-            av_write_frame(output_ctx_, output_packet);
-            av_packet_unref(output_packet);
+    while (ReadPacket(packet) >= 0) {
+        if (packet->stream_index == audio_stream_index_) {
+            StatsCollector::Add(stats_.packets_read, 1);
+            const int64_t done = packet->pts != AV_NOPTS_VALUE ? packet->pts - start + packet->duration : 0;
+            av_packet_rescale_ts(packet, input_stream->time_base, output_time_base);
+            packet->stream_index = 0;
+            packet->pos = -1;
+            WritePacket(packet);
+            ReportProgress(done, expected);
         }
+        av_packet_unref(packet);
+    }
+
+    WriteTrailer();
+    av_packet_free(&packet);
+
+    ReportProgressComplete();
+}
+
+void AudioConverter::ConvertAudio() {
+    hot_loop_allocations_ = 0;
+    if (options_.pipelined && pipeline_granted_) {
+        ConvertAudioPipelined();
+        return;
+    }
+
+    AVPacket* input_packet = av_packet_alloc();
+    AVPacket* output_packet = av_packet_alloc();
+    AVFrame* input_frame = av_frame_alloc();
+    AVFrame* resampled_frame = av_frame_alloc();
+    AVFrame* output_frame = av_frame_alloc();
+
+    const int frame_size = TargetFrameSize(*output_codec_ctx_);
+
+    // Size the reusable frames once from the codec parameters.
+    int resampled_capacity = InitialResampledCapacity();
+    AllocateAudioFrame(resampled_frame, resampled_capacity);
+    AllocateAudioFrame(output_frame, frame_size);
 
-        av_frame_unref(output_frame);
+    // Between reads the FIFO holds less than one encoder frame, so one resampled frame plus one
+    // encoder frame is the most it ever needs.
+    SampleRingBuffer fifo;
+    fifo.Reset(output_codec_ctx_->sample_fmt, output_codec_ctx_->ch_layout.nb_channels, resampled_capacity + frame_size);
+
+    int64_t pts = 0;
+    int64_t processed_samples = 0;
+    const int64_t expected_samples = ExpectedOutputSamples();
 
-        if (progress_cb_ && expected_samples > 0) {
-            double progress = static_cast<double>(processed_samples) / static_cast<double>(expected_samples);
-            if (progress > 1.0) {
-                progress = 1.0;
+    while (ReadPacket(input_packet) >= 0) {
+        if (input_packet->stream_index == audio_stream_index_) {
+            if (SendToDecoder(input_packet) < 0) {
+                throw std::runtime_error("Failed to send packet to decoder");
+            }
+
+            while (ReceiveDecoded(input_frame) >= 0) {
+                ResampleIntoFifo(input_frame, resampled_frame, resampled_capacity, fifo, hot_loop_allocations_);
+
+                while (fifo.Size() >= frame_size) {
+                    FillOutputFrame(output_frame, fifo, frame_size, hot_loop_allocations_);
+                    output_frame->pts = pts;
+                    pts += frame_size;
+                    processed_samples += frame_size;
+
+                    EncodeAndWrite(output_frame, output_packet);
+                    ReportProgress(processed_samples, expected_samples);
+                }
             }
-            progress_cb_(progress);
         }
+
+        av_packet_unref(input_packet);
     }
 
-    avcodec_send_frame(output_codec_ctx_, nullptr);
-    while (avcodec_receive_packet(output_codec_ctx_, output_packet) == 0) {
-        output_packet->stream_index = 0;
-        av_write_frame(output_ctx_, output_packet);
-        av_packet_unref(output_packet);
+    while (fifo.Size() > 0) {
+        int remaining = std::min(fifo.Size(), frame_size);
+
+        FillOutputFrame(output_frame, fifo, remaining, hot_loop_allocations_);
+        output_frame->pts = pts;
+        pts += remaining;
+        processed_samples += remaining;
+
+        EncodeAndWrite(output_frame, output_packet);
+        ReportProgress(processed_samples, expected_samples);
     }
 
-    av_write_trailer(output_ctx_);
+    EncodeAndWrite(nullptr, output_packet);
+
+    WriteTrailer();
 
-    av_audio_fifo_free(fifo);
     av_packet_free(&input_packet);
     av_packet_free(&output_packet);
     av_frame_free(&input_frame);
     av_frame_free(&resampled_frame);
     av_frame_free(&output_frame);
 
-    if (progress_cb_) {
-        progress_cb_(1.0);
+    ReportProgressComplete();
+}
+
+void AudioConverter::ConvertAudioPipelined() {
+    const int depth = std::max(2, options_.pipeline_depth);
+    const int frame_size = TargetFrameSize(*output_codec_ctx_);
+    const int64_t expected_samples = ExpectedOutputSamples();
+
+    // Every frame is owned here and only its pointer travels through the queues; a nullptr
+    // item marks end of stream. Each *_free queue returns frames to the stage that fills them.
+    std::vector<AVFrame*> decoded_pool;
+    std::vector<AVFrame*> output_pool;
+    SpscQueue<AVFrame*> decoded_queue(static_cast<std::size_t>(depth) + 1);
+    SpscQueue<AVFrame*> decoded_free(static_cast<std::size_t>(depth));
+    SpscQueue<AVFrame*> output_queue(static_cast<std::size_t>(depth) + 1);
+    SpscQueue<AVFrame*> output_free(static_cast<std::size_t>(depth));
+    AVFrame* resampled_frame = av_frame_alloc();
+    AVPacket* input_packet = av_packet_alloc();
+    AVPacket* output_packet = av_packet_alloc();
+
+    auto release = [&]() {
+        for (AVFrame*& frame : decoded_pool) {
+            av_frame_free(&frame);
+        }
+        for (AVFrame*& frame : output_pool) {
+            av_frame_free(&frame);
+        }
+        av_frame_free(&resampled_frame);
+        av_packet_free(&input_packet);
+        av_packet_free(&output_packet);
+    };
+
+    int resampled_capacity = 0;
+    try {
+        for (int i = 0; i < depth; ++i) {
+            decoded_pool.push_back(av_frame_alloc());
+            decoded_free.TryPush(decoded_pool.back());
+            output_pool.push_back(av_frame_alloc());
+            AllocateAudioFrame(output_pool.back(), frame_size);
+            output_free.TryPush(output_pool.back());
+        }
+        resampled_capacity = InitialResampledCapacity();
+        AllocateAudioFrame(resampled_frame, resampled_capacity);
+    } catch (...) {
+        release();
+        throw;
     }
+
+    std::atomic<bool> abort{false};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto fail = [&]() {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) {
+            error = std::current_exception();
+        }
+        abort.store(true, std::memory_order_release);
+    };
+
+    // Stage 1: demux + decode.
+    std::thread decode_thread([&]() {
+        try {
+            AVFrame* frame = nullptr;
+            while (ReadPacket(input_packet) >= 0) {
+                if (input_packet->stream_index == audio_stream_index_) {
+                    if (SendToDecoder(input_packet) < 0) {
+                        throw std::runtime_error("Failed to send packet to decoder");
+                    }
+                    while (true) {
+                        if (frame == nullptr && !PopWait(decoded_free, frame, abort)) {
+                            return;
+                        }
+                        if (ReceiveDecoded(frame) < 0) {
+                            break;
+                        }
+                        if (!PushWait(decoded_queue, frame, abort)) {
+                            return;
+                        }
+                        frame = nullptr;
+                    }
+                }
+                av_packet_unref(input_packet);
+            }
+            PushWait(decoded_queue, static_cast<AVFrame*>(nullptr), abort);
+        } catch (...) {
+            fail();
+        }
+    });
+
+    // Stage 2: resample into the FIFO and cut encoder-sized frames.
+    int64_t resample_allocations = 0;
+    std::thread resample_thread([&]() {
+        try {
+            SampleRingBuffer fifo;
+            fifo.Reset(output_codec_ctx_->sample_fmt, output_codec_ctx_->ch_layout.nb_channels, resampled_capacity + frame_size);
+            int64_t pts = 0;
+            auto emit = [&](int nb_samples) {
+                AVFrame* out = nullptr;
+                if (!PopWait(output_free, out, abort)) {
+                    return false;
+                }
+                FillOutputFrame(out, fifo, nb_samples, resample_allocations);
+                out->pts = pts;
+                pts += nb_samples;
+                return PushWait(output_queue, out, abort);
+            };
+
+            AVFrame* decoded = nullptr;
+            while (PopWait(decoded_queue, decoded, abort)) {
+                if (decoded == nullptr) {
+                    while (fifo.Size() > 0) {
+                        if (!emit(std::min(fifo.Size(), frame_size))) {
+                            return;
+                        }
+                    }
+                    PushWait(output_queue, static_cast<AVFrame*>(nullptr), abort);
+                    return;
+                }
+                ResampleIntoFifo(decoded, resampled_frame, resampled_capacity, fifo, resample_allocations);
+                if (!PushWait(decoded_free, decoded, abort)) {
+                    return;
+                }
+                while (fifo.Size() >= frame_size) {
+                    if (!emit(frame_size)) {
+                        return;
+                    }
+                }
+            }
+        } catch (...) {
+            fail();
+        }
+    });
+
+    // Stage 3 (this thread): encode + mux.
+    try {
+        int64_t processed_samples = 0;
+        AVFrame* frame = nullptr;
+        while (PopWait(output_queue, frame, abort) && frame != nullptr) {
+            EncodeAndWrite(frame, output_packet);
+            processed_samples += frame->nb_samples;
+            ReportProgress(processed_samples, expected_samples);
+            if (!PushWait(output_free, frame, abort)) {
+                break;
+            }
+        }
+    } catch (...) {
+        fail();
+    }
+
+    decode_thread.join();
+    resample_thread.join();
+    hot_loop_allocations_ += resample_allocations;
+
+    if (error) {
+        release();
+        std::rethrow_exception(error);
+    }
+
+    try {
+        EncodeAndWrite(nullptr, output_packet);
+        WriteTrailer();
+    } catch (...) {
+        release();
+        throw;
+    }
+    release();
+
+    ReportProgressComplete();
 }
 
 void AudioConverter::Cleanup() {
+    CloseFile();
+    ReleaseCodecs();
+}
+
+void AudioConverter::CloseFile() {
     if (input_ctx_ != nullptr) {
         avformat_close_input(&input_ctx_);
         input_ctx_ = nullptr;
     }
+    // Custom IO is not owned by the format context; release it only after the close above.
+    mapped_input_.reset();
     if (output_ctx_ != nullptr) {
-        if (!(output_ctx_->oformat->flags & AVFMT_NOFILE)) {
+        if (output_writer_ != nullptr || stream_output_ != nullptr) {
+            output_ctx_->pb = nullptr;
+        } else if (output_ctx_->oformat != nullptr && !(output_ctx_->oformat->flags & AVFMT_NOFILE)) {
             avio_closep(&output_ctx_->pb);
         }
         avformat_free_context(output_ctx_);
         output_ctx_ = nullptr;
     }
+    output_writer_.reset();
+    stream_input_.reset();
+    stream_output_.reset();
+    expected_input_bytes_ = 0;
+}
+
+void AudioConverter::ReleaseCodecs() {
     if (input_codec_ctx_ != nullptr) {
         avcodec_free_context(&input_codec_ctx_);
         input_codec_ctx_ = nullptr;
@@ -334,19 +1053,597 @@ void AudioConverter::Cleanup() {
         swr_free(&resample_ctx_);
         resample_ctx_ = nullptr;
     }
+    sample_path_ = SamplePath::Resample;
+    resampler_ready_ = false;
 }
 
-void AudioConverter::ConvertFile(const std::string& input_path, const std::string& output_path) {
+ConversionStats AudioConverter::ConvertFile(const std::string& input_path, const std::string& output_path) {
+    if (SameFile(input_path, output_path)) {
+        throw std::runtime_error("Output would overwrite its input: " + output_path);
+    }
+    BeginStats();
+    ReleaseLinkedOutput(output_path);
+
+    std::unique_ptr<DedupCache> cache;
+    std::string cache_key;
+    if (!options_.dedup_cache_dir.empty()) {
+        cache = std::make_unique<DedupCache>(options_.dedup_cache_dir);
+        {
+            StageTimer timer(stats_.hash_ns);
+            cache_key = cache->KeyFor(input_path, ConfigFingerprint());
+        }
+        if (cache->Fetch(cache_key, output_path)) {
+            stats_.cache_hit.store(true, std::memory_order_relaxed);
+            ReportProgressComplete();
+            return FinishStats();
+        }
+    }
+
+    ThreadBudget::Lease lease = LeaseThreads();
+    ConversionStats stats;
     try {
         OpenInputFile(input_path);
-        SetupOutputFile(output_path);
-        SetupResampler();
-        ConvertAudio();
+        if (StreamCopyApplies()) {
+            // Nothing to decode or encode; this thread alone copies the packets.
+            lease.Shrink(1);
+            stats_.stream_copied.store(true, std::memory_order_relaxed);
+            SetupOutputFile(output_path, true);
+            RemuxAudio();
+        } else {
+            SetupOutputFile(output_path);
+            const int segments = std::min(SegmentCountForInput(), lease.Threads());
+            if (segments > 1) {
+                lease.Shrink(segments);
+                ConvertSegmented(input_path, segments);
+            } else {
+                lease.Shrink((pipeline_granted_ ? 3 : 1) + codec_extra_threads_);
+                SetupResampler();
+                ConvertAudio();
+            }
+        }
+        stats = FinishStats();
+        if (output_writer_ != nullptr) {
+            // Surface deferred write errors instead of losing them in Cleanup.
+            output_writer_->Close();
+        }
+    } catch (...) {
+        Cleanup();
+        throw;
+    }
+    if (options_.reuse_codecs) {
+        CloseFile();
+    } else {
+        Cleanup();
+    }
+    if (cache != nullptr) {
+        cache->Store(cache_key, output_path);
+    }
+    return stats;
+}
+
+void AudioConverter::ReleaseLinkedOutput(const std::string& output_path) {
+    // An output shared with the dedup cache (or other outputs) must be replaced, not truncated.
+    std::error_code ec;
+    if (std::filesystem::hard_link_count(output_path, ec) > 1 && !ec) {
+        std::filesystem::remove(output_path, ec);
+    }
+}
+
+ConversionStats AudioConverter::ConvertStream(int input_fd, int output_fd, int64_t expected_input_bytes) {
+    if (expected_input_bytes <= 0) {
+        struct stat st {};
+        if (::fstat(input_fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            expected_input_bytes = static_cast<int64_t>(st.st_size);
+        }
+    }
+    ThreadBudget::Lease lease = LeaseThreads();
+    // Streams are never segmented; keep only the pipeline and codec threads.
+    lease.Shrink((pipeline_granted_ ? 3 : 1) + codec_extra_threads_);
+    ConversionStats stats;
+    try {
+        stream_input_ = std::make_unique<FdStream>(input_fd, FdStream::Mode::Read);
+        stream_output_ = std::make_unique<FdStream>(output_fd, FdStream::Mode::Write);
+        expected_input_bytes_ = expected_input_bytes;
+        BeginStats();
+        OpenInputFile("pipe:");
+        if (StreamCopyApplies()) {
+            stats_.stream_copied.store(true, std::memory_order_relaxed);
+            SetupOutputFile("pipe:", true);
+            RemuxAudio();
+        } else {
+            SetupOutputFile("pipe:");
+            SetupResampler();
+            ConvertAudio();
+        }
+        stats = FinishStats();
     } catch (...) {
         Cleanup();
         throw;
     }
     Cleanup();
+    return stats;
+}
+
+ConversionStats AudioConverter::ConvertFile(const std::string& input_path,
+                                            const std::string& output_path,
+                                            const SegmentOptions& segments) {
+    const SegmentOptions previous = options_.segments;
+    options_.segments = segments;
+    ConversionStats stats;
+    try {
+        stats = ConvertFile(input_path, output_path);
+    } catch (...) {
+        options_.segments = previous;
+        throw;
+    }
+    options_.segments = previous;
+    return stats;
+}
+
+struct AudioConverter::FanoutSink {
+    // Shares the input contexts of the fan-out converter, which stays their owner.
+    std::unique_ptr<AudioConverter> encoder;
+    SampleRingBuffer fifo;
+    AVFrame* frame = nullptr;
+    int frame_size = 0;
+    int64_t pts = 0;
+
+    ~FanoutSink() {
+        DetachInput();
+        av_frame_free(&frame);
+    }
+
+    void DetachInput() {
+        if (encoder != nullptr) {
+            encoder->input_ctx_ = nullptr;
+            encoder->input_codec_ctx_ = nullptr;
+        }
+    }
+};
+
+struct AudioConverter::FanoutGroup {
+    // The first sink's converter owns the resampler (or bypass path) of the group.
+    AudioConverter* resampler = nullptr;
+    std::vector<FanoutSink*> sinks;
+    AVFrame* resampled_frame = nullptr;
+    int resampled_capacity = 0;
+    // With several sinks the group resamples here once and copies the result to each sink.
+    SampleRingBuffer staging;
+    AVFrame* staged_frame = nullptr;
+    int staged_capacity = 0;
+
+    ~FanoutGroup() {
+        av_frame_free(&resampled_frame);
+        av_frame_free(&staged_frame);
+    }
+};
+
+ConversionStats AudioConverter::ConvertFileFanout(const std::string& input_path, const std::vector<FanoutOutput>& outputs) {
+    if (outputs.empty()) {
+        throw std::runtime_error("Fan-out conversion needs at least one output");
+    }
+    for (const FanoutOutput& output : outputs) {
+        if (SameFile(input_path, output.output_path)) {
+            throw std::runtime_error("Output would overwrite its input: " + output.output_path);
+        }
+    }
+    BeginStats();
+    for (const FanoutOutput& output : outputs) {
+        ReleaseLinkedOutput(output.output_path);
+    }
+
+    // Everything runs on this thread and the encoders stay single-threaded; only the decoder
+    // takes codec threads.
+    ThreadBudget::Lease lease = LeaseThreads();
+    lease.Shrink(1 + codec_extra_threads_ / 2);
+
+    ConverterOptions sink_options = options_;
+    sink_options.pipelined = false;
+    sink_options.segments = SegmentOptions{};
+    sink_options.dedup_cache_dir.clear();
+    sink_options.codec_threads = 0;
+
+    std::vector<std::unique_ptr<FanoutSink>> sinks;
+    ConversionStats stats;
+    try {
+        OpenInputFile(input_path);
+        for (const FanoutOutput& output : outputs) {
+            const AudioConverter& format = output.encoder != nullptr ? *output.encoder : *this;
+            sinks.push_back(std::make_unique<FanoutSink>());
+            FanoutSink& sink = *sinks.back();
+            sink.encoder = format.Clone();
+            sink.encoder->SetOptions(sink_options);
+            if (output.bitrate > 0) {
+                sink.encoder->bitrate_bps_ = output.bitrate;
+            }
+            sink.encoder->BeginStats();
+            sink.encoder->input_ctx_ = input_ctx_;
+            sink.encoder->input_codec_ctx_ = input_codec_ctx_;
+            sink.encoder->audio_stream_index_ = audio_stream_index_;
+            sink.encoder->SetupOutputFile(output.output_path);
+        }
+        ConvertAudioFanout(sinks);
+        for (const std::unique_ptr<FanoutSink>& sink : sinks) {
+            // Input bytes are counted once, by this converter.
+            sink->DetachInput();
+            stats_.Merge(sink->encoder->FinishStats());
+            if (sink->encoder->output_writer_ != nullptr) {
+                sink->encoder->output_writer_->Close();
+            }
+        }
+        stats = FinishStats();
+    } catch (...) {
+        sinks.clear();
+        Cleanup();
+        throw;
+    }
+    sinks.clear();
+    Cleanup();
+    return stats;
+}
+
+void AudioConverter::ConvertAudioFanout(std::vector<std::unique_ptr<FanoutSink>>& sinks) {
+    hot_loop_allocations_ = 0;
+
+    // Outputs whose encoders take the same rate, layout and sample format share one resampler.
+    std::vector<std::unique_ptr<FanoutGroup>> groups;
+    for (const std::unique_ptr<FanoutSink>& sink : sinks) {
+        const AVCodecContext& codec = *sink->encoder->output_codec_ctx_;
+        FanoutGroup* group = nullptr;
+        for (const std::unique_ptr<FanoutGroup>& candidate : groups) {
+            const AVCodecContext& other = *candidate->resampler->output_codec_ctx_;
+            if (other.sample_rate == codec.sample_rate && other.sample_fmt == codec.sample_fmt &&
+                av_channel_layout_compare(&other.ch_layout, &codec.ch_layout) == 0) {
+                group = candidate.get();
+                break;
+            }
+        }
+        if (group == nullptr) {
+            groups.push_back(std::make_unique<FanoutGroup>());
+            group = groups.back().get();
+            group->resampler = sink->encoder.get();
+            group->resampler->SetupResampler();
+            group->resampled_frame = av_frame_alloc();
+            group->resampled_capacity = group->resampler->InitialResampledCapacity();
+            group->resampler->AllocateAudioFrame(group->resampled_frame, group->resampled_capacity);
+        }
+        group->sinks.push_back(sink.get());
+
+        sink->frame_size = sink->encoder->TargetFrameSize(codec);
+        sink->frame = av_frame_alloc();
+        sink->encoder->AllocateAudioFrame(sink->frame, sink->frame_size);
+        sink->fifo.Reset(codec.sample_fmt, codec.ch_layout.nb_channels, group->resampled_capacity + sink->frame_size);
+    }
+    for (const std::unique_ptr<FanoutGroup>& group : groups) {
+        if (group->sinks.size() > 1) {
+            const AVCodecContext& codec = *group->resampler->output_codec_ctx_;
+            group->staging.Reset(codec.sample_fmt, codec.ch_layout.nb_channels, group->resampled_capacity);
+            group->staged_frame = av_frame_alloc();
+            group->staged_capacity = group->resampled_capacity;
+            group->resampler->AllocateAudioFrame(group->staged_frame, group->staged_capacity);
+        }
+    }
+
+    AVPacket* input_packet = av_packet_alloc();
+    AVPacket* output_packet = av_packet_alloc();
+    AVFrame* input_frame = av_frame_alloc();
+
+    auto feed = [&](FanoutGroup& group) {
+        AudioConverter& resampler = *group.resampler;
+        if (group.sinks.size() == 1) {
+            resampler.ResampleIntoFifo(input_frame, group.resampled_frame, group.resampled_capacity,
+                                       group.sinks.front()->fifo, hot_loop_allocations_);
+            return;
+        }
+        const int converted = resampler.ResampleIntoFifo(input_frame, group.resampled_frame, group.resampled_capacity,
+                                                         group.staging, hot_loop_allocations_);
+        if (converted > group.staged_capacity) {
+            group.staged_capacity = converted;
+            resampler.AllocateAudioFrame(group.staged_frame, group.staged_capacity);
+            ++hot_loop_allocations_;
+        }
+        if (!group.staging.Read(group.staged_frame->data, converted)) {
+            throw std::runtime_error("FIFO read failed");
+        }
+        for (FanoutSink* sink : group.sinks) {
+            if (sink->fifo.Space() < converted && sink->fifo.Reserve(sink->fifo.Size() + converted)) {
+                ++hot_loop_allocations_;
+            }
+            if (!sink->fifo.Write(group.staged_frame->data, converted)) {
+                throw std::runtime_error("Could not write to FIFO");
+            }
+        }
+    };
+
+    // Encode every whole frame the sink holds; when flushing, the short tail too.
+    auto drain = [&](FanoutSink& sink, bool flush) {
+        while (sink.fifo.Size() >= sink.frame_size || (flush && sink.fifo.Size() > 0)) {
+            const int samples = std::min(sink.fifo.Size(), sink.frame_size);
+            sink.encoder->FillOutputFrame(sink.frame, sink.fifo, samples, hot_loop_allocations_);
+            sink.frame->pts = sink.pts;
+            sink.pts += samples;
+            sink.encoder->EncodeAndWrite(sink.frame, output_packet);
+        }
+    };
+
+    // Every output advances through the same input, so progress follows the first one.
+    FanoutSink& lead = *sinks.front();
+    const int64_t expected_samples = lead.encoder->ExpectedOutputSamples();
+
+    while (ReadPacket(input_packet) >= 0) {
+        if (input_packet->stream_index == audio_stream_index_) {
+            if (SendToDecoder(input_packet) < 0) {
+                throw std::runtime_error("Failed to send packet to decoder");
+            }
+
+            while (ReceiveDecoded(input_frame) >= 0) {
+                for (const std::unique_ptr<FanoutGroup>& group : groups) {
+                    feed(*group);
+                }
+                for (const std::unique_ptr<FanoutSink>& sink : sinks) {
+                    drain(*sink, false);
+                }
+                ReportProgress(lead.pts, expected_samples);
+            }
+        }
+
+        av_packet_unref(input_packet);
+    }
+
+    for (const std::unique_ptr<FanoutSink>& sink : sinks) {
+        drain(*sink, true);
+        sink->encoder->EncodeAndWrite(nullptr, output_packet);
+        sink->encoder->WriteTrailer();
+    }
+
+    av_packet_free(&input_packet);
+    av_packet_free(&output_packet);
+    av_frame_free(&input_frame);
+
+    ReportProgressComplete();
+}
+
+int AudioConverter::SegmentWarmupSamples() const {
+    const int frame_size = TargetFrameSize(*output_codec_ctx_);
+    const int64_t warmup = av_rescale(std::max(0, options_.segments.overlap_ms), output_codec_ctx_->sample_rate, 1000);
+    return static_cast<int>((warmup + frame_size - 1) / frame_size) * frame_size;
+}
+
+int AudioConverter::SegmentCountForInput() const {
+    const SegmentOptions& segments = options_.segments;
+    if (segments.count <= 1 || input_ctx_ == nullptr || input_ctx_->duration <= 0) {
+        return 1;
+    }
+    const double duration_seconds = static_cast<double>(input_ctx_->duration) / AV_TIME_BASE;
+    if (duration_seconds < segments.min_duration_seconds) {
+        return 1;
+    }
+    // Keep every segment long enough that the discarded warm-up stays a small fraction of it.
+    const double min_segment_seconds = std::max(30.0, 20.0 * segments.overlap_ms / 1000.0);
+    const int max_segments = static_cast<int>(duration_seconds / min_segment_seconds);
+    return std::max(1, std::min(segments.count, max_segments));
+}
+
+void AudioConverter::ConvertSegmented(const std::string& input_path, int segment_count) {
+    const int frame_size = TargetFrameSize(*output_codec_ctx_);
+    const int64_t total_frames = (ExpectedOutputSamples() + frame_size - 1) / frame_size;
+    const int64_t frames_per_segment = (total_frames + segment_count - 1) / segment_count;
+    const int warmup = SegmentWarmupSamples();
+
+    // Workers encode on their own contexts; only this converter's muxer writes the file.
+    ConverterOptions worker_options = options_;
+    worker_options.segments = SegmentOptions{};
+    worker_options.pipelined = false;
+    worker_options.output_buffer_bytes = 0;
+
+    std::vector<std::vector<AVPacket*>> packets(static_cast<std::size_t>(segment_count));
+    std::vector<std::exception_ptr> errors(static_cast<std::size_t>(segment_count));
+    std::vector<std::thread> workers;
+    std::atomic<int64_t> encoded_samples{0};
+    // Set by the first failing segment so the others stop instead of encoding a discarded range.
+    std::atomic<bool> abort{false};
+    // Serialises progress callbacks, which come from every segment thread.
+    std::mutex progress_mutex;
+    const int64_t expected_samples = ExpectedOutputSamples();
+
+    for (int i = 0; i < segment_count; ++i) {
+        SegmentRange range;
+        range.start = static_cast<int64_t>(i) * frames_per_segment * frame_size;
+        range.end = static_cast<int64_t>(i + 1) * frames_per_segment * frame_size;
+        range.warmup = warmup;
+        range.last = (i == segment_count - 1);
+        const std::size_t slot = static_cast<std::size_t>(i);
+        workers.emplace_back([&, range, slot]() {
+            try {
+                std::unique_ptr<AudioConverter> worker = Clone();
+                worker->SetOptions(worker_options);
+                worker->EncodeSegment(input_path, range, packets[slot], [&](int64_t samples) {
+                    const int64_t done = encoded_samples.fetch_add(samples, std::memory_order_relaxed) + samples;
+                    std::unique_lock<std::mutex> lock(progress_mutex, std::try_to_lock);
+                    if (lock.owns_lock()) {
+                        ReportProgress(done, expected_samples);
+                    }
+                }, abort);
+                stats_.Merge(worker->stats_.Snapshot());
+            } catch (...) {
+                errors[slot] = std::current_exception();
+                abort.store(true, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    // Mux in segment order as soon as each segment is ready. The ranges tile the timeline and
+    // every encoder stamps packets from the absolute sample position, so granule positions are
+    // continuous without rewriting.
+    std::exception_ptr error;
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        workers[i].join();
+        if (!error && errors[i]) {
+            error = errors[i];
+        }
+        for (AVPacket*& packet : packets[i]) {
+            if (!error) {
+                packet->stream_index = 0;
+                WritePacket(packet);
+            }
+            av_packet_free(&packet);
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    WriteTrailer();
+
+    ReportProgressComplete();
+}
+
+void AudioConverter::EncodeSegment(const std::string& input_path,
+                                   const SegmentRange& range,
+                                   std::vector<AVPacket*>& packets,
+                                   const std::function<void(int64_t)>& on_samples,
+                                   const std::atomic<bool>& abort) {
+    AVPacket* input_packet = nullptr;
+    AVPacket* output_packet = nullptr;
+    AVFrame* input_frame = nullptr;
+    AVFrame* resampled_frame = nullptr;
+    AVFrame* output_frame = nullptr;
+    auto release = [&]() {
+        av_packet_free(&input_packet);
+        av_packet_free(&output_packet);
+        av_frame_free(&input_frame);
+        av_frame_free(&resampled_frame);
+        av_frame_free(&output_frame);
+        Cleanup();
+    };
+
+    try {
+        OpenInputFile(input_path);
+        OpenEncoder();
+        SetupResampler();
+
+        input_packet = av_packet_alloc();
+        output_packet = av_packet_alloc();
+        input_frame = av_frame_alloc();
+        resampled_frame = av_frame_alloc();
+        output_frame = av_frame_alloc();
+
+        const int frame_size = TargetFrameSize(*output_codec_ctx_);
+        const int sample_rate = output_codec_ctx_->sample_rate;
+        int resampled_capacity = InitialResampledCapacity();
+        AllocateAudioFrame(resampled_frame, resampled_capacity);
+        AllocateAudioFrame(output_frame, frame_size);
+        SampleRingBuffer fifo;
+        fifo.Reset(output_codec_ctx_->sample_fmt, output_codec_ctx_->ch_layout.nb_channels, resampled_capacity + frame_size);
+
+        const AVStream* stream = input_ctx_->streams[audio_stream_index_];
+        const AVRational output_time_base{1, sample_rate};
+        const int64_t stream_start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+        const int64_t encode_from = std::max<int64_t>(0, range.start - range.warmup);
+        const int64_t encode_until = range.last ? INT64_MAX : range.end + range.warmup;
+
+        if (encode_from > 0) {
+            // Land half a second early so the decoder's bit reservoir is primed before encode_from.
+            const int64_t seek_samples = std::max<int64_t>(0, encode_from - sample_rate / 2);
+            const int64_t timestamp = stream_start + av_rescale_q(seek_samples, output_time_base, stream->time_base);
+            if (av_seek_frame(input_ctx_, audio_stream_index_, timestamp, AVSEEK_FLAG_BACKWARD) < 0) {
+                throw std::runtime_error("Could not seek to segment start");
+            }
+        }
+
+        // Packets in [keep_from, keep_until) belong to this segment; the rest is warm-up.
+        const int64_t padding = output_codec_ctx_->initial_padding;
+        const int64_t keep_from = range.start == 0 ? INT64_MIN : range.start - padding;
+        const int64_t keep_until = range.last ? INT64_MAX : range.end - padding;
+        auto encode = [&](AVFrame* frame) {
+            if (SendToEncoder(frame) < 0) {
+                if (frame == nullptr) {
+                    return;
+                }
+                throw std::runtime_error("Encoder send failed");
+            }
+            while (ReceiveEncoded(output_packet) == 0) {
+                if (output_packet->pts >= keep_from && output_packet->pts < keep_until) {
+                    packets.push_back(av_packet_clone(output_packet));
+                    on_samples(output_packet->duration);
+                }
+                av_packet_unref(output_packet);
+            }
+        };
+
+        // Absolute output-sample position just past the newest sample in the FIFO.
+        int64_t position = AV_NOPTS_VALUE;
+        bool done = false;
+        while (!done && !abort.load(std::memory_order_relaxed) && ReadPacket(input_packet) >= 0) {
+            if (input_packet->stream_index == audio_stream_index_) {
+                if (SendToDecoder(input_packet) < 0) {
+                    throw std::runtime_error("Failed to send packet to decoder");
+                }
+                while (!done && ReceiveDecoded(input_frame) >= 0) {
+                    if (position == AV_NOPTS_VALUE) {
+                        const int64_t timestamp = input_frame->best_effort_timestamp;
+                        if (timestamp == AV_NOPTS_VALUE) {
+                            throw std::runtime_error("Segment start has no timestamp");
+                        }
+                        position = av_rescale_q(timestamp - stream_start, stream->time_base, output_time_base);
+                        if (position > encode_from) {
+                            throw std::runtime_error("Segment seek landed past its start");
+                        }
+                    }
+                    position += ResampleIntoFifo(input_frame, resampled_frame, resampled_capacity, fifo, hot_loop_allocations_);
+
+                    int64_t fifo_start = position - fifo.Size();
+                    if (fifo_start < encode_from) {
+                        const int drop = static_cast<int>(std::min<int64_t>(encode_from - fifo_start, fifo.Size()));
+                        fifo.Discard(drop);
+                        fifo_start += drop;
+                    }
+                    while (fifo.Size() >= frame_size) {
+                        if (fifo_start >= encode_until) {
+                            done = true;
+                            break;
+                        }
+                        FillOutputFrame(output_frame, fifo, frame_size, hot_loop_allocations_);
+                        output_frame->pts = fifo_start;
+                        fifo_start += frame_size;
+                        encode(output_frame);
+                    }
+                }
+            }
+            av_packet_unref(input_packet);
+        }
+        if (abort.load(std::memory_order_relaxed)) {
+            // Another segment failed; its error is the one reported and these packets are dropped.
+            release();
+            return;
+        }
+
+        if (range.last) {
+            int64_t fifo_start = position - fifo.Size();
+            while (fifo.Size() > 0) {
+                const int remaining = std::min(fifo.Size(), frame_size);
+                FillOutputFrame(output_frame, fifo, remaining, hot_loop_allocations_);
+                output_frame->pts = fifo_start;
+                fifo_start += remaining;
+                encode(output_frame);
+            }
+        }
+        encode(nullptr);
+        StatsCollector::Add(stats_.bytes_read, input_ctx_->pb->bytes_read);
+    } catch (...) {
+        release();
+        throw;
+    }
+    release();
+}
+
+std::string AudioConverter::OutputPathFor(const std::string& input_file,
+                                          const std::string& input_dir,
+                                          const std::string& output_dir) const {
+    std::filesystem::path relative_path = std::filesystem::relative(input_file, input_dir);
+    std::filesystem::path output_file = std::filesystem::path(output_dir) / relative_path;
+    output_file.replace_extension(PreferredContainer(output_file.string()));
+    return output_file.string();
 }
 
 void AudioConverter::ConvertDirectory(const std::string& input_dir, const std::string& output_dir) {
@@ -354,19 +1651,183 @@ void AudioConverter::ConvertDirectory(const std::string& input_dir, const std::s
     std::filesystem::path output_path(output_dir);
     std::filesystem::create_directories(output_path);
 
-    for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(input_path)) {
-        if (entry.is_regular_file() && ShouldConvertFile(entry.path().extension().string())) {
-            std::string input_file = entry.path().string();
-            std::filesystem::path relative_path = std::filesystem::relative(entry.path(), input_path);
-            std::filesystem::path output_file = output_path / relative_path;
-            output_file.replace_extension(PreferredContainer(output_file.string()));
-            std::filesystem::create_directories(output_file.parent_path());
+    std::unique_ptr<ConversionManifest> manifest = LoadManifest(options_.incremental, output_dir);
+    const std::string fingerprint = ConfigFingerprint();
 
-            try {
-                ConvertFile(input_file, output_file.string());
-            } catch (const std::exception& e) {
-                (void)e;
+    try {
+        const std::filesystem::recursive_directory_iterator end;
+        for (std::filesystem::recursive_directory_iterator it(input_path); it != end; ++it) {
+            const std::filesystem::directory_entry& entry = *it;
+            if (entry.is_directory() && SameFile(entry.path().string(), output_dir)) {
+                // The output tree sits inside the input tree; its files are earlier outputs.
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (entry.is_regular_file() && ShouldConvertFile(entry.path().extension().string())) {
+                std::string input_file = entry.path().string();
+                std::filesystem::path output_file = OutputPathFor(input_file, input_dir, output_dir);
+                if (SameFile(input_file, output_file.string())) {
+                    continue;
+                }
+
+                const std::string key = ConversionManifest::KeyFor(entry.path());
+                ConversionManifest::Entry record;
+                const bool tracked = manifest != nullptr && ConversionManifest::Describe(entry.path(), fingerprint, record);
+                if (tracked && manifest->IsCurrent(key, record) && std::filesystem::exists(output_file)) {
+                    continue;
+                }
+
+                std::filesystem::create_directories(output_file.parent_path());
+                try {
+                    ConvertFile(input_file, output_file.string());
+                    if (tracked) {
+                        manifest->Record(key, record);
+                    }
+                } catch (const std::exception& e) {
+                    (void)e;
+                    if (manifest != nullptr) {
+                        manifest->Forget(key);
+                    }
+                }
+                if (manifest != nullptr) {
+                    manifest->Checkpoint(kManifestCheckpointInterval);
+                }
+            }
+        }
+    } catch (...) {
+        if (manifest != nullptr) {
+            manifest->Save();
+        }
+        throw;
+    }
+    if (manifest != nullptr) {
+        manifest->Save();
+    }
+}
+
+std::vector<FileConversionResult> AudioConverter::ConvertDirectory(const std::string& input_dir,
+                                                                   const std::string& output_dir,
+                                                                   const ParallelOptions& options) {
+    std::filesystem::path input_path(input_dir);
+    std::filesystem::create_directories(output_dir);
+
+    int worker_count = options.worker_count;
+    if (worker_count <= 0) {
+        worker_count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    std::unique_ptr<ConversionManifest> manifest = LoadManifest(options_.incremental, output_dir);
+    const std::string fingerprint = ConfigFingerprint();
+
+    // Queue item: the public result plus what is needed to record it in the manifest.
+    struct DirectoryJob {
+        FileConversionResult result;
+        std::string key;
+        ConversionManifest::Entry record;
+        bool tracked = false;
+    };
+
+    BoundedQueue<DirectoryJob> queue(options.queue_capacity);
+    std::vector<FileConversionResult> results;
+    std::mutex results_mutex;
+    auto finish = [&](FileConversionResult&& result) {
+        if (options.on_file_done) {
+            options.on_file_done(result);
+        }
+        std::lock_guard<std::mutex> lock(results_mutex);
+        results.push_back(std::move(result));
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(static_cast<std::size_t>(worker_count));
+    // Cloned before any worker starts, so a failing Clone() reaches the caller instead of
+    // escaping a thread and calling std::terminate.
+    std::vector<std::unique_ptr<AudioConverter>> converters;
+    converters.reserve(static_cast<std::size_t>(worker_count));
+    for (int i = 0; i < worker_count; ++i) {
+        converters.push_back(Clone());
+        converters.back()->SetOptions(options_);
+    }
+    for (int i = 0; i < worker_count; ++i) {
+        workers.emplace_back([converter = converters[static_cast<std::size_t>(i)].get(), &queue, &manifest, &finish]() {
+            DirectoryJob job;
+            while (queue.Pop(job)) {
+                FileConversionResult& result = job.result;
+                try {
+                    std::filesystem::create_directories(std::filesystem::path(result.output_path).parent_path());
+                    result.stats = converter->ConvertFile(result.input_path, result.output_path);
+                    result.success = true;
+                } catch (const std::exception& e) {
+                    result.success = false;
+                    result.error = e.what();
+                }
+                if (manifest != nullptr) {
+                    if (result.success && job.tracked) {
+                        manifest->Record(job.key, job.record);
+                    } else if (!result.success) {
+                        manifest->Forget(job.key);
+                    }
+                    try {
+                        manifest->Checkpoint(kManifestCheckpointInterval);
+                    } catch (const std::exception&) {
+                        // The final Save reports persistent failures to the caller.
+                    }
+                }
+                finish(std::move(result));
+            }
+        });
+    }
+
+    // Feed the pool while the tree is still being walked so conversion starts immediately.
+    // Up-to-date files are settled here without ever reaching a worker.
+    std::exception_ptr walk_error;
+    try {
+        const std::filesystem::recursive_directory_iterator end;
+        for (std::filesystem::recursive_directory_iterator it(input_path); it != end; ++it) {
+            const std::filesystem::directory_entry& entry = *it;
+            if (entry.is_directory() && SameFile(entry.path().string(), output_dir)) {
+                // The output tree sits inside the input tree; its files are earlier outputs.
+                it.disable_recursion_pending();
+                continue;
+            }
+            if (entry.is_regular_file() && ShouldConvertFile(entry.path().extension().string())) {
+                DirectoryJob job;
+                job.result.input_path = entry.path().string();
+                job.result.output_path = OutputPathFor(job.result.input_path, input_dir, output_dir);
+                if (SameFile(job.result.input_path, job.result.output_path)) {
+                    continue;
+                }
+                if (manifest != nullptr) {
+                    job.key = ConversionManifest::KeyFor(entry.path());
+                    job.tracked = ConversionManifest::Describe(entry.path(), fingerprint, job.record);
+                    if (job.tracked && manifest->IsCurrent(job.key, job.record) &&
+                        std::filesystem::exists(job.result.output_path)) {
+                        job.result.success = true;
+                        job.result.skipped = true;
+                        finish(std::move(job.result));
+                        continue;
+                    }
+                }
+                queue.Push(std::move(job));
             }
         }
+    } catch (...) {
+        walk_error = std::current_exception();
+    }
+
+    queue.Close();
+    for (std::thread& worker : workers) {
+        worker.join();
     }
+    if (manifest != nullptr) {
+        manifest->Save();
+    }
+    if (walk_error) {
+        std::rethrow_exception(walk_error);
+    }
+
+    std::sort(results.begin(), results.end(), [](const FileConversionResult& a, const FileConversionResult& b) {
+        return a.input_path < b.input_path;
+    });
+    return results;
 }
@@ -0,0 +1,179 @@
+#include "converter/ContentHasher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+constexpr uint64_t kPrime1 = 11400714785074694791ULL;
+constexpr uint64_t kPrime2 = 14029467366897019727ULL;
+constexpr uint64_t kPrime3 = 1609587929392839161ULL;
+constexpr uint64_t kPrime4 = 9650029242287828579ULL;
+constexpr uint64_t kPrime5 = 2870177450012600261ULL;
+constexpr std::size_t kReadChunk = 1 << 20;
+
+inline uint64_t Rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t Read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t Read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t Round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = Rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline uint64_t Merge(uint64_t hash, uint64_t acc) {
+    hash ^= Round(0, acc);
+    return hash * kPrime1 + kPrime4;
+}
+}
+
+ContentHasher::ContentHasher(uint64_t seed)
+    : acc_{seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1},
+      buffer_{},
+      buffered_(0),
+      total_(0),
+      seed_(seed) {}
+
+void ContentHasher::Update(const void* data, std::size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    total_ += size;
+
+    if (buffered_ > 0) {
+        const std::size_t take = std::min(size, sizeof(buffer_) - buffered_);
+        std::memcpy(buffer_ + buffered_, p, take);
+        buffered_ += take;
+        p += take;
+        size -= take;
+        if (buffered_ < sizeof(buffer_)) {
+            return;
+        }
+        for (int lane = 0; lane < 4; ++lane) {
+            acc_[lane] = Round(acc_[lane], Read64(buffer_ + lane * 8));
+        }
+        buffered_ = 0;
+    }
+
+    // Four independent lanes keep the multipliers busy; this is where the bulk of the time goes.
+    uint64_t v1 = acc_[0];
+    uint64_t v2 = acc_[1];
+    uint64_t v3 = acc_[2];
+    uint64_t v4 = acc_[3];
+    while (size >= 32) {
+        v1 = Round(v1, Read64(p));
+        v2 = Round(v2, Read64(p + 8));
+        v3 = Round(v3, Read64(p + 16));
+        v4 = Round(v4, Read64(p + 24));
+        p += 32;
+        size -= 32;
+    }
+    acc_[0] = v1;
+    acc_[1] = v2;
+    acc_[2] = v3;
+    acc_[3] = v4;
+
+    if (size > 0) {
+        std::memcpy(buffer_, p, size);
+        buffered_ = size;
+    }
+}
+
+uint64_t ContentHasher::Digest() const {
+    uint64_t hash;
+    if (total_ >= 32) {
+        hash = Rotl(acc_[0], 1) + Rotl(acc_[1], 7) + Rotl(acc_[2], 12) + Rotl(acc_[3], 18);
+        for (uint64_t acc : acc_) {
+            hash = Merge(hash, acc);
+        }
+    } else {
+        hash = seed_ + kPrime5;
+    }
+    hash += total_;
+
+    const unsigned char* p = buffer_;
+    std::size_t remaining = buffered_;
+    while (remaining >= 8) {
+        hash ^= Round(0, Read64(p));
+        hash = Rotl(hash, 27) * kPrime1 + kPrime4;
+        p += 8;
+        remaining -= 8;
+    }
+    if (remaining >= 4) {
+        hash ^= static_cast<uint64_t>(Read32(p)) * kPrime1;
+        hash = Rotl(hash, 23) * kPrime2 + kPrime3;
+        p += 4;
+        remaining -= 4;
+    }
+    while (remaining > 0) {
+        hash ^= (*p) * kPrime5;
+        hash = Rotl(hash, 11) * kPrime1;
+        ++p;
+        --remaining;
+    }
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+uint64_t ContentHasher::HashFile(const std::filesystem::path& path, uint64_t& size) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open " + path.string() + " for hashing");
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    ContentHasher hasher;
+    std::vector<unsigned char> chunk(kReadChunk);
+    while (true) {
+        const ssize_t n = ::read(fd, chunk.data(), chunk.size());
+        if (n > 0) {
+            hasher.Update(chunk.data(), static_cast<std::size_t>(n));
+        } else if (n == 0) {
+            break;
+        } else if (errno != EINTR) {
+            ::close(fd);
+            throw std::runtime_error("Could not read " + path.string() + " for hashing");
+        }
+    }
+    ::close(fd);
+    size = hasher.total_;
+    return hasher.Digest();
+}
+
+uint64_t ContentHasher::HashString(const std::string& text, uint64_t seed) {
+    ContentHasher hasher(seed);
+    hasher.Update(text.data(), text.size());
+    return hasher.Digest();
+}
+
+std::string ContentHasher::ToHex(uint64_t value) {
+    static const char kDigits[] = "0123456789abcdef";
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; --i) {
+        hex[static_cast<std::size_t>(i)] = kDigits[value & 0xf];
+        value >>= 4;
+    }
+    return hex;
+}
@@ -0,0 +1,212 @@
+#include "converter/ConversionManifest.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace {
+// Bump when the line or key format changes; files with another header are treated as empty.
+// v2 keys entries by absolute input path instead of the path relative to the input directory.
+constexpr const char* kHeader = "# audio-converter manifest v2";
+
+// Unique sibling name so concurrent savers never write into each other's temporary.
+std::filesystem::path TempSibling(const std::filesystem::path& target) {
+    static std::atomic<unsigned> counter{0};
+    std::filesystem::path tmp = target;
+    tmp += ".tmp" + std::to_string(::getpid()) + "-" +
+           std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + "-" +
+           std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+    return tmp;
+}
+
+// Exclusive flock held for its lifetime. flock locks belong to the open file, so two instances
+// in one process exclude each other as well as separate processes do.
+class FileLock {
+public:
+    explicit FileLock(const std::filesystem::path& path)
+        : fd_(::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)) {
+        if (fd_ < 0) {
+            throw std::runtime_error("Could not open manifest lock " + path.string() + ": " + std::strerror(errno));
+        }
+        while (::flock(fd_, LOCK_EX) != 0) {
+            if (errno != EINTR) {
+                const int error = errno;
+                ::close(fd_);
+                throw std::runtime_error("Could not lock manifest " + path.string() + ": " + std::strerror(error));
+            }
+        }
+    }
+    ~FileLock() { ::close(fd_); }
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+private:
+    int fd_;
+};
+
+// A missing file or another header leaves entries empty; malformed lines are ignored.
+void ReadEntries(const std::filesystem::path& file, std::unordered_map<std::string, ConversionManifest::Entry>& entries) {
+    std::ifstream in(file);
+    if (!in.is_open()) {
+        return;
+    }
+
+    // Format: size <TAB> mtime_ns <TAB> fingerprint <TAB> key. The key comes last so it may contain tabs.
+    std::string line;
+    if (!std::getline(in, line) || line != kHeader) {
+        return;
+    }
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        ConversionManifest::Entry entry;
+        std::string key;
+        if (!(fields >> entry.size >> entry.mtime_ns >> entry.fingerprint) || fields.get() != '\t') {
+            continue;
+        }
+        std::getline(fields, key);
+        if (!key.empty()) {
+            entries[key] = std::move(entry);
+        }
+    }
+}
+}
+
+ConversionManifest::ConversionManifest(std::filesystem::path file)
+    : file_(std::move(file)),
+      last_save_(std::chrono::steady_clock::now()) {}
+
+std::filesystem::path ConversionManifest::PathFor(const std::filesystem::path& output_dir) {
+    return output_dir / ".conversion-manifest";
+}
+
+std::string ConversionManifest::KeyFor(const std::filesystem::path& input) {
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(input, ec);
+    if (ec) {
+        canonical = std::filesystem::absolute(input, ec).lexically_normal();
+    }
+    return (ec ? input : canonical).generic_string();
+}
+
+bool ConversionManifest::Describe(const std::filesystem::path& input, const std::string& fingerprint, Entry& entry) {
+    std::error_code ec;
+    const uintmax_t size = std::filesystem::file_size(input, ec);
+    if (ec) {
+        return false;
+    }
+    const std::filesystem::file_time_type mtime = std::filesystem::last_write_time(input, ec);
+    if (ec) {
+        return false;
+    }
+    entry.size = static_cast<uint64_t>(size);
+    entry.mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+    entry.fingerprint = fingerprint;
+    return true;
+}
+
+void ConversionManifest::Load() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    changed_.clear();
+    ReadEntries(file_, entries_);
+}
+
+void ConversionManifest::Save() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SaveLocked();
+}
+
+void ConversionManifest::Checkpoint(std::chrono::seconds interval) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (std::chrono::steady_clock::now() - last_save_ >= interval) {
+        SaveLocked();
+    }
+}
+
+void ConversionManifest::SaveLocked() {
+    last_save_ = std::chrono::steady_clock::now();
+    if (changed_.empty()) {
+        return;
+    }
+    std::filesystem::path lock_path = file_;
+    lock_path += ".lock";
+    FileLock file_lock(lock_path);
+
+    // Other runs into the same output tree may have saved since Load; keep their entries and
+    // apply only what this instance changed.
+    std::unordered_map<std::string, Entry> merged;
+    ReadEntries(file_, merged);
+    for (const std::string& key : changed_) {
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            merged[key] = it->second;
+        } else {
+            merged.erase(key);
+        }
+    }
+
+    const std::filesystem::path tmp = TempSibling(file_);
+    std::error_code ec;
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("Could not write manifest " + tmp.string());
+        }
+        out << kHeader << '\n';
+        for (const auto& [key, entry] : merged) {
+            out << entry.size << '\t' << entry.mtime_ns << '\t' << entry.fingerprint << '\t' << key << '\n';
+        }
+        if (!out.flush()) {
+            out.close();
+            std::filesystem::remove(tmp, ec);
+            throw std::runtime_error("Could not write manifest " + tmp.string());
+        }
+    }
+    std::filesystem::rename(tmp, file_, ec);
+    if (ec) {
+        const std::string reason = ec.message();
+        std::filesystem::remove(tmp, ec);
+        throw std::runtime_error("Could not replace manifest " + file_.string() + ": " + reason);
+    }
+    entries_ = std::move(merged);
+    changed_.clear();
+}
+
+bool ConversionManifest::IsCurrent(const std::string& key, const Entry& entry) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    return it != entries_.end() &&
+           it->second.size == entry.size &&
+           it->second.mtime_ns == entry.mtime_ns &&
+           it->second.fingerprint == entry.fingerprint;
+}
+
+void ConversionManifest::Record(const std::string& key, const Entry& entry) {
+    // Keys and fingerprints are stored on one whitespace-separated line.
+    if (key.find('\n') != std::string::npos || entry.fingerprint.empty() ||
+        entry.fingerprint.find_first_of(" \t\n") != std::string::npos) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[key] = entry;
+    changed_.insert(key);
+}
+
+void ConversionManifest::Forget(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Marked even when unknown here: another run may have recorded it on disk since Load.
+    entries_.erase(key);
+    changed_.insert(key);
+}
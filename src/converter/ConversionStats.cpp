@@ -0,0 +1,63 @@
+#include "converter/ConversionStats.hpp"
+
+#include <initializer_list>
+
+namespace {
+constexpr std::memory_order kRelaxed = std::memory_order_relaxed;
+}
+
+void StatsCollector::Reset() {
+    for (std::atomic<int64_t>* counter : {&wall_ns, &demux_ns, &decode_ns, &resample_ns, &encode_ns, &mux_ns,
+                                          &bytes_read, &bytes_written, &packets_read, &packets_written,
+                                          &frames_decoded, &frames_encoded, &samples_encoded, &hash_ns}) {
+        counter->store(0, kRelaxed);
+    }
+    peak_fifo_samples.store(0, kRelaxed);
+    cache_hit.store(false, kRelaxed);
+    stream_copied.store(false, kRelaxed);
+}
+
+void StatsCollector::RaisePeakFifo(int samples) {
+    int current = peak_fifo_samples.load(kRelaxed);
+    while (samples > current && !peak_fifo_samples.compare_exchange_weak(current, samples, kRelaxed)) {
+    }
+}
+
+void StatsCollector::Merge(const ConversionStats& other) {
+    Add(demux_ns, other.demux_ns);
+    Add(decode_ns, other.decode_ns);
+    Add(resample_ns, other.resample_ns);
+    Add(encode_ns, other.encode_ns);
+    Add(mux_ns, other.mux_ns);
+    Add(bytes_read, other.bytes_read);
+    Add(bytes_written, other.bytes_written);
+    Add(packets_read, other.packets_read);
+    Add(packets_written, other.packets_written);
+    Add(frames_decoded, other.frames_decoded);
+    Add(frames_encoded, other.frames_encoded);
+    Add(samples_encoded, other.samples_encoded);
+    Add(hash_ns, other.hash_ns);
+    RaisePeakFifo(other.peak_fifo_samples);
+}
+
+ConversionStats StatsCollector::Snapshot() const {
+    ConversionStats stats;
+    stats.wall_ns = wall_ns.load(kRelaxed);
+    stats.demux_ns = demux_ns.load(kRelaxed);
+    stats.decode_ns = decode_ns.load(kRelaxed);
+    stats.resample_ns = resample_ns.load(kRelaxed);
+    stats.encode_ns = encode_ns.load(kRelaxed);
+    stats.mux_ns = mux_ns.load(kRelaxed);
+    stats.bytes_read = bytes_read.load(kRelaxed);
+    stats.bytes_written = bytes_written.load(kRelaxed);
+    stats.packets_read = packets_read.load(kRelaxed);
+    stats.packets_written = packets_written.load(kRelaxed);
+    stats.frames_decoded = frames_decoded.load(kRelaxed);
+    stats.frames_encoded = frames_encoded.load(kRelaxed);
+    stats.samples_encoded = samples_encoded.load(kRelaxed);
+    stats.peak_fifo_samples = peak_fifo_samples.load(kRelaxed);
+    stats.hash_ns = hash_ns.load(kRelaxed);
+    stats.cache_hit = cache_hit.load(kRelaxed);
+    stats.stream_copied = stream_copied.load(kRelaxed);
+    return stats;
+}
@@ -0,0 +1,111 @@
+#include "converter/DedupCache.hpp"
+
+#include "converter/ContentHasher.hpp"
+
+#include <atomic>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+namespace {
+// Unique sibling name so concurrent workers never share a temporary.
+std::filesystem::path TempSibling(const std::filesystem::path& target) {
+    static std::atomic<unsigned> counter{0};
+    std::filesystem::path tmp = target;
+    tmp += ".tmp" + std::to_string(::getpid()) + "-" +
+           std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + "-" +
+           std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+    return tmp;
+}
+
+bool Reflink(const std::filesystem::path& from, const std::filesystem::path& to) {
+#ifdef FICLONE
+    const int src = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (src < 0) {
+        return false;
+    }
+    const int dst = ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (dst < 0) {
+        ::close(src);
+        return false;
+    }
+    const bool cloned = ::ioctl(dst, FICLONE, src) == 0;
+    ::close(src);
+    ::close(dst);
+    if (!cloned) {
+        std::error_code ec;
+        std::filesystem::remove(to, ec);
+    }
+    return cloned;
+#else
+    (void)from;
+    (void)to;
+    return false;
+#endif
+}
+
+// Create target as a link/clone/copy of source, atomically replacing whatever was there.
+bool Place(const std::filesystem::path& source, const std::filesystem::path& target) {
+    const std::filesystem::path tmp = TempSibling(target);
+    std::error_code ec;
+    std::filesystem::create_hard_link(source, tmp, ec);
+    if (ec && !Reflink(source, tmp)) {
+        ec.clear();
+        std::filesystem::copy_file(source, tmp, std::filesystem::copy_options::overwrite_existing, ec);
+        if (ec) {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp, target, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+}
+
+DedupCache::DedupCache(std::filesystem::path root)
+    : root_(std::move(root)) {}
+
+std::string DedupCache::KeyFor(const std::filesystem::path& input, const std::string& fingerprint) const {
+    uint64_t size = 0;
+    const uint64_t content = ContentHasher::HashFile(input, size);
+    return ContentHasher::ToHex(content) + "-" + std::to_string(size) + "-" +
+           ContentHasher::ToHex(ContentHasher::HashString(fingerprint));
+}
+
+std::filesystem::path DedupCache::EntryPath(const std::string& key) const {
+    // Fan out over 256 directories so no single directory grows huge.
+    return root_ / key.substr(0, 2) / key;
+}
+
+bool DedupCache::Fetch(const std::string& key, const std::filesystem::path& output) const {
+    const std::filesystem::path entry = EntryPath(key);
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(entry, ec)) {
+        return false;
+    }
+    return Place(entry, output);
+}
+
+void DedupCache::Store(const std::string& key, const std::filesystem::path& output) const {
+    const std::filesystem::path entry = EntryPath(key);
+    std::error_code ec;
+    if (std::filesystem::exists(entry, ec)) {
+        return;
+    }
+    std::filesystem::create_directories(entry.parent_path(), ec);
+    if (!ec) {
+        Place(output, entry);
+    }
+}
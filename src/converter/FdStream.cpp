@@ -0,0 +1,78 @@
+#include "converter/FdStream.hpp"
+
+#include <cerrno>
+#include <stdexcept>
+
+#include <unistd.h>
+
+extern "C" {
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+namespace {
+constexpr int kAvioBufferSize = 64 * 1024;
+}
+
+FdStream::FdStream(int fd, Mode mode)
+    : fd_(fd),
+      avio_(nullptr),
+      bytes_(0) {
+    if (fd_ < 0) {
+        throw std::runtime_error("Invalid file descriptor");
+    }
+    unsigned char* buffer = static_cast<unsigned char*>(av_malloc(kAvioBufferSize));
+    if (buffer != nullptr) {
+        const bool writing = (mode == Mode::Write);
+        avio_ = avio_alloc_context(buffer, kAvioBufferSize, writing ? 1 : 0, this,
+                                   writing ? nullptr : &FdStream::Read,
+                                   writing ? &FdStream::Write : nullptr,
+                                   nullptr);
+    }
+    if (avio_ == nullptr) {
+        av_free(buffer);
+        throw std::runtime_error("Could not allocate stream AVIOContext");
+    }
+    avio_->seekable = 0;
+}
+
+FdStream::~FdStream() {
+    if (avio_ != nullptr) {
+        av_freep(&avio_->buffer);
+        avio_context_free(&avio_);
+    }
+}
+
+int FdStream::Read(void* opaque, uint8_t* buf, int buf_size) {
+    FdStream* self = static_cast<FdStream*>(opaque);
+    while (true) {
+        const ssize_t n = ::read(self->fd_, buf, static_cast<std::size_t>(buf_size));
+        if (n > 0) {
+            self->bytes_.fetch_add(n, std::memory_order_relaxed);
+            return static_cast<int>(n);
+        }
+        if (n == 0) {
+            return AVERROR_EOF;
+        }
+        if (errno != EINTR) {
+            return AVERROR(errno);
+        }
+    }
+}
+
+int FdStream::Write(void* opaque, WriteBuffer buf, int buf_size) {
+    FdStream* self = static_cast<FdStream*>(opaque);
+    int done = 0;
+    while (done < buf_size) {
+        const ssize_t n = ::write(self->fd_, buf + done, static_cast<std::size_t>(buf_size - done));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return AVERROR(errno);
+        }
+        done += static_cast<int>(n);
+    }
+    self->bytes_.fetch_add(done, std::memory_order_relaxed);
+    return done;
+}
@@ -0,0 +1,216 @@
+#include "converter/JobJournal.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+constexpr int kSyncEveryRecords = 64;
+constexpr std::chrono::milliseconds kSyncInterval(1000);
+
+char EventCode(JobJournal::Event event) {
+    switch (event) {
+        case JobJournal::Event::Enqueued: return 'E';
+        case JobJournal::Event::Started: return 'S';
+        case JobJournal::Event::Finished: return 'F';
+        case JobJournal::Event::Failed: return 'X';
+        case JobJournal::Event::Removed: return 'R';
+    }
+    return '?';
+}
+
+// One record per line, so backslashes and newlines in job names are escaped.
+std::string Escape(const std::string& job) {
+    std::string out;
+    out.reserve(job.size());
+    for (const char c : job) {
+        if (c == '\\') {
+            out += "\\\\";
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+std::string Unescape(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 1 < text.size()) {
+            ++i;
+            out += (text[i] == 'n') ? '\n' : text[i];
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
+
+void WriteAll(int fd, const std::string& data, const std::filesystem::path& file) {
+    std::size_t done = 0;
+    while (done < data.size()) {
+        const ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Could not write job journal " + file.string() + ": " + std::strerror(errno));
+        }
+        done += static_cast<std::size_t>(n);
+    }
+}
+
+void SyncDirectory(const std::filesystem::path& file) {
+    std::filesystem::path dir = file.parent_path();
+    if (dir.empty()) {
+        dir = ".";
+    }
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+}
+
+JobJournal::JobJournal(std::filesystem::path file)
+    : file_(std::move(file)),
+      fd_(-1),
+      unsynced_records_(0),
+      last_sync_(std::chrono::steady_clock::now()) {}
+
+JobJournal::~JobJournal() {
+    if (fd_ >= 0) {
+        ::fdatasync(fd_);
+        ::close(fd_);
+    }
+}
+
+std::vector<std::string> JobJournal::Open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    // Replay: each enqueue adds one pending copy of a job (it may be queued twice), each
+    // finish, failure or removal settles one.
+    std::vector<std::string> order;
+    std::unordered_map<std::string, int> pending;
+    {
+        std::ifstream in(file_);
+        std::string line;
+        while (std::getline(in, line)) {
+            // A torn final line from a crash has no terminating newline and is dropped here.
+            if (in.eof() || line.size() < 3 || line[1] != ' ') {
+                continue;
+            }
+            const std::string job = Unescape(line.substr(2));
+            switch (line[0]) {
+                case 'E':
+                    order.push_back(job);
+                    ++pending[job];
+                    break;
+                case 'F':
+                case 'X':
+                case 'R': {
+                    auto it = pending.find(job);
+                    if (it != pending.end() && it->second > 0) {
+                        --it->second;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+    std::vector<std::string> jobs;
+    for (std::string& job : order) {
+        int& remaining = pending[job];
+        if (remaining > 0) {
+            --remaining;
+            jobs.push_back(std::move(job));
+        }
+    }
+
+    // Compact: the rewritten journal holds one enqueue record per unfinished job.
+    if (!file_.parent_path().empty()) {
+        std::filesystem::create_directories(file_.parent_path());
+    }
+    std::filesystem::path tmp = file_;
+    tmp += ".tmp";
+    const int tmp_fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (tmp_fd < 0) {
+        throw std::runtime_error("Could not create job journal " + tmp.string() + ": " + std::strerror(errno));
+    }
+    try {
+        std::string contents;
+        for (const std::string& job : jobs) {
+            contents += "E " + Escape(job) + "\n";
+        }
+        WriteAll(tmp_fd, contents, tmp);
+        if (::fdatasync(tmp_fd) != 0) {
+            throw std::runtime_error("Could not sync job journal " + tmp.string());
+        }
+    } catch (...) {
+        ::close(tmp_fd);
+        throw;
+    }
+    ::close(tmp_fd);
+    if (::rename(tmp.c_str(), file_.c_str()) != 0) {
+        throw std::runtime_error("Could not replace job journal " + file_.string() + ": " + std::strerror(errno));
+    }
+    SyncDirectory(file_);
+
+    fd_ = ::open(file_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("Could not open job journal " + file_.string() + ": " + std::strerror(errno));
+    }
+    unsynced_records_ = 0;
+    last_sync_ = std::chrono::steady_clock::now();
+    return jobs;
+}
+
+void JobJournal::Record(Event event, const std::string& job) {
+    const std::string line = std::string(1, EventCode(event)) + " " + Escape(job) + "\n";
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0) {
+        throw std::runtime_error("Job journal is not open");
+    }
+    // O_APPEND keeps each record contiguous even with other writers on the same file.
+    WriteAll(fd_, line, file_);
+    ++unsynced_records_;
+
+    // The queue itself must survive a power loss; progress records can be batched.
+    const bool queue_change = (event == Event::Enqueued || event == Event::Removed);
+    if (queue_change || unsynced_records_ >= kSyncEveryRecords ||
+        std::chrono::steady_clock::now() - last_sync_ >= kSyncInterval) {
+        SyncLocked();
+    }
+}
+
+void JobJournal::Sync() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SyncLocked();
+}
+
+void JobJournal::SyncLocked() {
+    if (fd_ < 0 || unsynced_records_ == 0) {
+        return;
+    }
+    if (::fdatasync(fd_) != 0) {
+        throw std::runtime_error("Could not sync job journal " + file_.string() + ": " + std::strerror(errno));
+    }
+    unsynced_records_ = 0;
+    last_sync_ = std::chrono::steady_clock::now();
+}
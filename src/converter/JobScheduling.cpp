@@ -0,0 +1,95 @@
+#include "converter/JobScheduling.hpp"
+#include "converter/AudioConverter.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace {
+constexpr const char* kPolicyNames[] = {"fifo", "shortest", "longest"};
+
+// Bitrate assumed when only a file's size is known; typical of the MP3s being converted.
+constexpr double kAssumedBitsPerSecond = 128000.0;
+
+double SecondsFromSize(std::uintmax_t bytes) {
+    return static_cast<double>(bytes) * 8.0 / kAssumedBitsPerSecond;
+}
+
+// Opens the container without avformat_find_stream_info, so only durations written in the
+// header (e.g. an MP3 Xing/VBRI frame or the Ogg/FLAC stream info) are seen; 0 otherwise.
+double HeaderDurationSeconds(const std::string& path) {
+    AVFormatContext* ctx = nullptr;
+    if (avformat_open_input(&ctx, path.c_str(), nullptr, nullptr) < 0) {
+        return 0.0;
+    }
+    double seconds = 0.0;
+    const int stream_index = av_find_best_stream(ctx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    if (ctx->duration > 0) {
+        seconds = static_cast<double>(ctx->duration) / AV_TIME_BASE;
+    } else if (stream_index >= 0 && ctx->streams[stream_index]->duration > 0) {
+        const AVStream* stream = ctx->streams[stream_index];
+        seconds = static_cast<double>(stream->duration) * av_q2d(stream->time_base);
+    }
+    avformat_close_input(&ctx);
+    return seconds;
+}
+}
+
+SchedulingPolicy SchedulingPolicyFromName(const std::string& name) {
+    if (name == "fifo") {
+        return SchedulingPolicy::Fifo;
+    }
+    if (name == "shortest") {
+        return SchedulingPolicy::ShortestFirst;
+    }
+    if (name == "longest") {
+        return SchedulingPolicy::LongestFirst;
+    }
+    throw std::runtime_error("Unknown job order: " + name + " (expected fifo, shortest or longest)");
+}
+
+const std::vector<std::string>& SchedulingPolicyNames() {
+    static const std::vector<std::string> names(std::begin(kPolicyNames), std::end(kPolicyNames));
+    return names;
+}
+
+double EstimateJobSeconds(const std::string& path, const AudioConverter& filter) {
+    std::error_code ec;
+    if (std::filesystem::is_directory(path, ec)) {
+        // Probing every file of a tree would cost more than the reordering saves.
+        std::uintmax_t bytes = 0;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(path, ec)) {
+            if (entry.is_regular_file(ec) && filter.AcceptsInput(entry.path().string())) {
+                bytes += entry.file_size(ec);
+            }
+        }
+        return SecondsFromSize(bytes);
+    }
+    const double seconds = HeaderDurationSeconds(path);
+    if (seconds > 0.0) {
+        return seconds;
+    }
+    const std::uintmax_t bytes = std::filesystem::file_size(path, ec);
+    return ec ? 0.0 : SecondsFromSize(bytes);
+}
+
+void OrderJobs(std::vector<std::string>& jobs,
+               SchedulingPolicy policy,
+               const std::unordered_map<std::string, double>& seconds) {
+    if (policy == SchedulingPolicy::Fifo) {
+        return;
+    }
+    std::stable_sort(jobs.begin(), jobs.end(), [&](const std::string& a, const std::string& b) {
+        const auto a_it = seconds.find(a);
+        const auto b_it = seconds.find(b);
+        if (a_it == seconds.end() || b_it == seconds.end()) {
+            return a_it != seconds.end() && b_it == seconds.end();
+        }
+        return policy == SchedulingPolicy::ShortestFirst ? a_it->second < b_it->second
+                                                         : a_it->second > b_it->second;
+    });
+}
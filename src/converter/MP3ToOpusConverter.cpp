@@ -7,8 +7,15 @@ extern "C" {
 #include <libavutil/opt.h>
 }
 
-MP3ToOpusConverter::MP3ToOpusConverter(int bitrate)
-    : AudioConverter(bitrate) {}
+MP3ToOpusConverter::MP3ToOpusConverter(int bitrate, const OpusProfile& profile)
+    : AudioConverter(bitrate),
+      profile_(profile) {
+    profile_.Validate();
+}
+
+std::unique_ptr<AudioConverter> MP3ToOpusConverter::Clone() const {
+    return std::make_unique<MP3ToOpusConverter>(bitrate_bps_, profile_);
+}
 
 AVCodecID MP3ToOpusConverter::OutputCodecId() const {
     return AV_CODEC_ID_OPUS;
@@ -42,9 +49,15 @@ void MP3ToOpusConverter::ConfigureOutputCodecContext(AVCodecContext& output_ctx,
         av_channel_layout_default(&output_ctx.ch_layout, 2);
     }
 
-    av_opt_set_int(&output_ctx, "frame_size", 960, 0);
-    av_opt_set_int(&output_ctx, "vbr", 1, 0);
-    output_ctx.compression_level = 10;
+    // frame_duration, application and vbr are private options of the libopus wrapper, so they
+    // have to be looked up in the codec's child object; the encoder derives frame_size from
+    // frame_duration when it opens. libopus maps compression_level to its complexity setting.
+    output_ctx.compression_level = profile_.complexity;
+    if (av_opt_set_double(&output_ctx, "frame_duration", profile_.FrameDurationMs(), AV_OPT_SEARCH_CHILDREN) < 0 ||
+        av_opt_set(&output_ctx, "application", profile_.application.c_str(), AV_OPT_SEARCH_CHILDREN) < 0 ||
+        av_opt_set(&output_ctx, "vbr", profile_.vbr.c_str(), AV_OPT_SEARCH_CHILDREN) < 0) {
+        throw std::runtime_error("Opus encoder rejected profile '" + profile_.name + "'");
+    }
 }
 
 std::string MP3ToOpusConverter::PreferredContainer(const std::string& output_path) const {
@@ -53,10 +66,17 @@ std::string MP3ToOpusConverter::PreferredContainer(const std::string& output_pat
 }
 
 int MP3ToOpusConverter::TargetFrameSize(const AVCodecContext& output_ctx) const {
-    (void)output_ctx;
-    return 960;
+    if (output_ctx.frame_size > 0) {
+        return output_ctx.frame_size;
+    }
+    return profile_.frame_size;
+}
+
+std::string MP3ToOpusConverter::ConfigFingerprint() const {
+    return AudioConverter::ConfigFingerprint() + profile_.Fingerprint();
 }
 
 bool MP3ToOpusConverter::ShouldConvertFile(const std::string& extension) const {
-    return extension == ".mp3";
+    // Opus inputs are only worth picking up when they can be copied instead of re-encoded.
+    return extension == ".mp3" || (Options().stream_copy && extension == ".opus");
 }
@@ -0,0 +1,103 @@
+#include "converter/MappedInput.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+namespace {
+constexpr int kAvioBufferSize = 64 * 1024;
+}
+
+MappedInput::MappedInput(const std::string& path)
+    : data_(nullptr),
+      size_(0),
+      pos_(0),
+      avio_(nullptr) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open input file: " + path);
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not map empty or unreadable input file: " + path);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+
+    void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file referenced; the descriptor is no longer needed.
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("Could not mmap input file: " + path);
+    }
+    ::madvise(mapping, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const uint8_t*>(mapping);
+
+    unsigned char* buffer = static_cast<unsigned char*>(av_malloc(kAvioBufferSize));
+    if (buffer != nullptr) {
+        avio_ = avio_alloc_context(buffer, kAvioBufferSize, 0, this, &MappedInput::Read, nullptr, &MappedInput::Seek);
+    }
+    if (avio_ == nullptr) {
+        av_free(buffer);
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+        throw std::runtime_error("Could not allocate input AVIOContext");
+    }
+}
+
+MappedInput::~MappedInput() {
+    if (avio_ != nullptr) {
+        av_freep(&avio_->buffer);
+        avio_context_free(&avio_);
+    }
+    if (data_ != nullptr) {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+int MappedInput::Read(void* opaque, uint8_t* buf, int buf_size) {
+    MappedInput* self = static_cast<MappedInput*>(opaque);
+    if (self->pos_ >= self->size_) {
+        return AVERROR_EOF;
+    }
+    const std::size_t count = std::min(static_cast<std::size_t>(buf_size), self->size_ - self->pos_);
+    std::memcpy(buf, self->data_ + self->pos_, count);
+    self->pos_ += count;
+    return static_cast<int>(count);
+}
+
+int64_t MappedInput::Seek(void* opaque, int64_t offset, int whence) {
+    MappedInput* self = static_cast<MappedInput*>(opaque);
+    whence &= ~AVSEEK_FORCE;
+    int64_t target = 0;
+    switch (whence) {
+    case AVSEEK_SIZE:
+        return static_cast<int64_t>(self->size_);
+    case SEEK_SET:
+        target = offset;
+        break;
+    case SEEK_CUR:
+        target = static_cast<int64_t>(self->pos_) + offset;
+        break;
+    case SEEK_END:
+        target = static_cast<int64_t>(self->size_) + offset;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (target < 0) {
+        return AVERROR(EINVAL);
+    }
+    self->pos_ = std::min(static_cast<std::size_t>(target), self->size_);
+    return static_cast<int64_t>(self->pos_);
+}
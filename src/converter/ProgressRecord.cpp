@@ -0,0 +1,48 @@
+#include "converter/ProgressRecord.hpp"
+
+double ProgressRecord::Snapshot::Fraction() const {
+    if (samples_expected <= 0) {
+        return 0.0;
+    }
+    const double fraction = static_cast<double>(samples_done) / static_cast<double>(samples_expected);
+    return fraction > 1.0 ? 1.0 : fraction;
+}
+
+void ProgressRecord::Publish(int64_t samples_done, int64_t samples_expected, uint64_t file_id) {
+    // An odd sequence marks a write in progress; the fence orders it before the field stores.
+    const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    samples_done_.store(samples_done, std::memory_order_relaxed);
+    samples_expected_.store(samples_expected, std::memory_order_relaxed);
+    file_id_.store(file_id, std::memory_order_relaxed);
+    sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+void ProgressRecord::Complete() {
+    // Only the writer calls this, so its own fields cannot change underneath it.
+    const int64_t expected = samples_expected_.load(std::memory_order_relaxed);
+    const uint64_t file_id = file_id_.load(std::memory_order_relaxed);
+    if (expected > 0) {
+        Publish(expected, expected, file_id);
+    } else {
+        Publish(1, 1, file_id);
+    }
+}
+
+ProgressRecord::Snapshot ProgressRecord::Read() const {
+    Snapshot snapshot;
+    while (true) {
+        const uint32_t before = sequence_.load(std::memory_order_acquire);
+        if (before & 1U) {
+            continue;
+        }
+        snapshot.samples_done = samples_done_.load(std::memory_order_relaxed);
+        snapshot.samples_expected = samples_expected_.load(std::memory_order_relaxed);
+        snapshot.file_id = file_id_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) == before) {
+            return snapshot;
+        }
+    }
+}
@@ -0,0 +1,248 @@
+#include "converter/SampleKernels.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SAMPLE_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr float kS16Scale = 1.0f / 32768.0f;
+
+int16_t ClampToS16(float value) {
+    // Written so NaN ends up at the lower bound, matching _mm_max_ps in the SIMD paths.
+    float scaled = value * 32768.0f;
+    scaled = scaled > -32768.0f ? scaled : -32768.0f;
+    scaled = scaled < 32767.0f ? scaled : 32767.0f;
+    return static_cast<int16_t>(std::lrintf(scaled));
+}
+
+void InterleaveStereoScalar(const uint32_t* left, const uint32_t* right, uint32_t* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        out[2 * i] = left[i];
+        out[2 * i + 1] = right[i];
+    }
+}
+
+void DeinterleaveStereoScalar(const uint32_t* in, uint32_t* left, uint32_t* right, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        left[i] = in[2 * i];
+        right[i] = in[2 * i + 1];
+    }
+}
+
+#ifdef SAMPLE_KERNELS_X86
+
+__attribute__((target("sse2")))
+void InterleaveStereoSse2(const uint32_t* left, const uint32_t* right, uint32_t* out, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 l = _mm_loadu_ps(reinterpret_cast<const float*>(left + i));
+        const __m128 r = _mm_loadu_ps(reinterpret_cast<const float*>(right + i));
+        _mm_storeu_ps(reinterpret_cast<float*>(out + 2 * i), _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(reinterpret_cast<float*>(out + 2 * i + 4), _mm_unpackhi_ps(l, r));
+    }
+    InterleaveStereoScalar(left + i, right + i, out + 2 * i, count - i);
+}
+
+__attribute__((target("sse2")))
+void DeinterleaveStereoSse2(const uint32_t* in, uint32_t* left, uint32_t* right, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 a = _mm_loadu_ps(reinterpret_cast<const float*>(in + 2 * i));
+        const __m128 b = _mm_loadu_ps(reinterpret_cast<const float*>(in + 2 * i + 4));
+        _mm_storeu_ps(reinterpret_cast<float*>(left + i), _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(reinterpret_cast<float*>(right + i), _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    DeinterleaveStereoScalar(in + 2 * i, left + i, right + i, count - i);
+}
+
+__attribute__((target("sse2")))
+void S16ToFloatSse2(const int16_t* in, float* out, std::size_t count) {
+    const __m128 scale = _mm_set1_ps(kS16Scale);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // Sign-extend by placing each s16 in the high half of a 32-bit lane and shifting back.
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    SampleKernels::S16ToFloatScalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("sse2")))
+void FloatToS16Sse2(const float* in, int16_t* out, std::size_t count) {
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 lower = _mm_set1_ps(-32768.0f);
+    const __m128 upper = _mm_set1_ps(32767.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), lower), upper);
+        const __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale), lower), upper);
+        const __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    SampleKernels::FloatToS16Scalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void InterleaveStereoAvx2(const uint32_t* left, const uint32_t* right, uint32_t* out, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 l = _mm256_loadu_ps(reinterpret_cast<const float*>(left + i));
+        const __m256 r = _mm256_loadu_ps(reinterpret_cast<const float*>(right + i));
+        // unpack works per 128-bit lane; the permutes put the four frames of each half in order.
+        const __m256 lo = _mm256_unpacklo_ps(l, r);
+        const __m256 hi = _mm256_unpackhi_ps(l, r);
+        _mm256_storeu_ps(reinterpret_cast<float*>(out + 2 * i), _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(reinterpret_cast<float*>(out + 2 * i + 8), _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    InterleaveStereoSse2(left + i, right + i, out + 2 * i, count - i);
+}
+
+__attribute__((target("avx2")))
+void DeinterleaveStereoAvx2(const uint32_t* in, uint32_t* left, uint32_t* right, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 a = _mm256_loadu_ps(reinterpret_cast<const float*>(in + 2 * i));
+        const __m256 b = _mm256_loadu_ps(reinterpret_cast<const float*>(in + 2 * i + 8));
+        const __m256 first = _mm256_permute2f128_ps(a, b, 0x20);
+        const __m256 second = _mm256_permute2f128_ps(a, b, 0x31);
+        _mm256_storeu_ps(reinterpret_cast<float*>(left + i), _mm256_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm256_storeu_ps(reinterpret_cast<float*>(right + i), _mm256_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    DeinterleaveStereoSse2(in + 2 * i, left + i, right + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void S16ToFloatAvx2(const int16_t* in, float* out, std::size_t count) {
+    const __m256 scale = _mm256_set1_ps(kS16Scale);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), scale));
+    }
+    S16ToFloatSse2(in + i, out + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void FloatToS16Avx2(const float* in, int16_t* out, std::size_t count) {
+    const __m256 scale = _mm256_set1_ps(32768.0f);
+    const __m256 lower = _mm256_set1_ps(-32768.0f);
+    const __m256 upper = _mm256_set1_ps(32767.0f);
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), scale), lower), upper);
+        const __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i + 8), scale), lower), upper);
+        // packs interleaves the 128-bit lanes of a and b; restore sample order afterwards.
+        const __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    FloatToS16Sse2(in + i, out + i, count - i);
+}
+
+#endif // SAMPLE_KERNELS_X86
+
+struct KernelTable {
+    const char* isa;
+    void (*interleave_stereo)(const uint32_t*, const uint32_t*, uint32_t*, std::size_t);
+    void (*deinterleave_stereo)(const uint32_t*, uint32_t*, uint32_t*, std::size_t);
+    void (*s16_to_float)(const int16_t*, float*, std::size_t);
+    void (*float_to_s16)(const float*, int16_t*, std::size_t);
+};
+
+KernelTable SelectKernels() {
+#ifdef SAMPLE_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {"avx2", InterleaveStereoAvx2, DeinterleaveStereoAvx2, S16ToFloatAvx2, FloatToS16Avx2};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return {"sse2", InterleaveStereoSse2, DeinterleaveStereoSse2, S16ToFloatSse2, FloatToS16Sse2};
+    }
+#endif
+    return {"scalar", InterleaveStereoScalar, DeinterleaveStereoScalar, SampleKernels::S16ToFloatScalar,
+            SampleKernels::FloatToS16Scalar};
+}
+
+const KernelTable& Kernels() {
+    static const KernelTable table = SelectKernels();
+    return table;
+}
+
+} // namespace
+
+namespace SampleKernels {
+
+const char* ActiveIsa() {
+    return Kernels().isa;
+}
+
+void Interleave32(const uint32_t* const* planes, uint32_t* interleaved, std::size_t count, int channels) {
+    if (channels == 1) {
+        std::memcpy(interleaved, planes[0], count * sizeof(uint32_t));
+    } else if (channels == 2) {
+        Kernels().interleave_stereo(planes[0], planes[1], interleaved, count);
+    } else {
+        Interleave32Scalar(planes, interleaved, count, channels);
+    }
+}
+
+void Deinterleave32(const uint32_t* interleaved, uint32_t* const* planes, std::size_t count, int channels) {
+    if (channels == 1) {
+        std::memcpy(planes[0], interleaved, count * sizeof(uint32_t));
+    } else if (channels == 2) {
+        Kernels().deinterleave_stereo(interleaved, planes[0], planes[1], count);
+    } else {
+        Deinterleave32Scalar(interleaved, planes, count, channels);
+    }
+}
+
+void S16ToFloat(const int16_t* in, float* out, std::size_t count) {
+    Kernels().s16_to_float(in, out, count);
+}
+
+void FloatToS16(const float* in, int16_t* out, std::size_t count) {
+    Kernels().float_to_s16(in, out, count);
+}
+
+void Interleave32Scalar(const uint32_t* const* planes, uint32_t* interleaved, std::size_t count, int channels) {
+    const std::size_t stride = static_cast<std::size_t>(channels);
+    for (int c = 0; c < channels; ++c) {
+        const uint32_t* in = planes[c];
+        uint32_t* out = interleaved + c;
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i * stride] = in[i];
+        }
+    }
+}
+
+void Deinterleave32Scalar(const uint32_t* interleaved, uint32_t* const* planes, std::size_t count, int channels) {
+    const std::size_t stride = static_cast<std::size_t>(channels);
+    for (int c = 0; c < channels; ++c) {
+        const uint32_t* in = interleaved + c;
+        uint32_t* out = planes[c];
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = in[i * stride];
+        }
+    }
+}
+
+void S16ToFloatScalar(const int16_t* in, float* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<float>(in[i]) * kS16Scale;
+    }
+}
+
+void FloatToS16Scalar(const float* in, int16_t* out, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] = ClampToS16(in[i]);
+    }
+}
+
+} // namespace SampleKernels
@@ -0,0 +1,313 @@
+#include "converter/SampleRingBuffer.hpp"
+
+#include "converter/SampleKernels.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+extern "C" {
+#include <libavutil/mem.h>
+}
+
+namespace {
+constexpr std::size_t kPlaneAlignment = 64;
+// The SIMD kernels take per-channel pointer arrays of this size; s16<->float conversions that also
+// change the plane layout go through a stack scratch block of kConvertBlock samples per channel.
+constexpr int kMaxKernelChannels = 8;
+constexpr int kConvertBlock = 256;
+
+std::size_t AlignUp(std::size_t value) {
+    return (value + kPlaneAlignment - 1) & ~(kPlaneAlignment - 1);
+}
+
+// Scalar fallback for repacks the kernels do not cover (other sample widths, many channels). The
+// ring side is addressed as storage + plane * stride, the frame side through its plane pointers.
+template <typename T>
+void Interleave(const uint8_t* const* src, int src_offset, uint8_t* dst, int dst_offset, int count, int channels) {
+    T* out = reinterpret_cast<T*>(dst) + static_cast<std::size_t>(dst_offset) * channels;
+    for (int c = 0; c < channels; ++c) {
+        const T* in = reinterpret_cast<const T*>(src[c]) + src_offset;
+        for (int i = 0; i < count; ++i) {
+            out[static_cast<std::size_t>(i) * channels + c] = in[i];
+        }
+    }
+}
+
+template <typename T>
+void Deinterleave(const uint8_t* src, int src_offset, uint8_t* dst, std::size_t stride, int dst_offset, int count, int channels) {
+    const T* in = reinterpret_cast<const T*>(src) + static_cast<std::size_t>(src_offset) * channels;
+    for (int c = 0; c < channels; ++c) {
+        T* out = reinterpret_cast<T*>(dst + static_cast<std::size_t>(c) * stride) + dst_offset;
+        for (int i = 0; i < count; ++i) {
+            out[i] = in[static_cast<std::size_t>(i) * channels + c];
+        }
+    }
+}
+
+template <typename T>
+void Repack(bool to_interleaved,
+            const uint8_t* const* src,
+            int src_offset,
+            uint8_t* storage,
+            std::size_t stride,
+            int dst_offset,
+            int count,
+            int channels) {
+    if (to_interleaved) {
+        Interleave<T>(src, src_offset, storage, dst_offset, count, channels);
+    } else {
+        Deinterleave<T>(src[0], src_offset, storage, stride, dst_offset, count, channels);
+    }
+}
+}
+
+SampleRingBuffer::SampleRingBuffer()
+    : storage_(nullptr),
+      plane_stride_(0),
+      sample_fmt_(AV_SAMPLE_FMT_NONE),
+      planes_(0),
+      channels_(0),
+      bytes_per_sample_(0),
+      sample_bytes_(0),
+      capacity_(0),
+      head_(0),
+      size_(0) {}
+
+SampleRingBuffer::~SampleRingBuffer() {
+    av_free(storage_);
+}
+
+void SampleRingBuffer::Reset(AVSampleFormat sample_fmt, int channels, int capacity) {
+    if (channels <= 0 || capacity <= 0) {
+        throw std::runtime_error("Invalid sample ring buffer layout");
+    }
+    const bool planar = av_sample_fmt_is_planar(sample_fmt) != 0;
+    const int bytes = av_get_bytes_per_sample(sample_fmt);
+    sample_fmt_ = sample_fmt;
+    planes_ = planar ? channels : 1;
+    channels_ = channels;
+    bytes_per_sample_ = bytes;
+    sample_bytes_ = planar ? bytes : bytes * channels;
+    capacity_ = 0;
+    head_ = 0;
+    size_ = 0;
+    av_freep(&storage_);
+    plane_stride_ = 0;
+    Reserve(capacity);
+}
+
+bool SampleRingBuffer::Reserve(int capacity) {
+    if (capacity <= capacity_) {
+        return false;
+    }
+    const std::size_t stride = AlignUp(static_cast<std::size_t>(capacity) * static_cast<std::size_t>(sample_bytes_));
+    uint8_t* storage = static_cast<uint8_t*>(av_malloc(stride * static_cast<std::size_t>(planes_)));
+    if (storage == nullptr) {
+        throw std::runtime_error("Could not allocate sample ring buffer");
+    }
+
+    // Linearise the buffered samples at the start of the new planes.
+    std::vector<uint8_t*> dst(static_cast<std::size_t>(planes_));
+    for (int p = 0; p < planes_; ++p) {
+        dst[static_cast<std::size_t>(p)] = storage + static_cast<std::size_t>(p) * stride;
+    }
+    const int buffered = size_;
+    if (buffered > 0) {
+        Read(dst.data(), buffered);
+    }
+
+    av_free(storage_);
+    storage_ = storage;
+    plane_stride_ = stride;
+    capacity_ = capacity;
+    head_ = 0;
+    size_ = buffered;
+    return true;
+}
+
+bool SampleRingBuffer::Write(const uint8_t* const* data, int nb_samples) {
+    if (nb_samples < 0 || nb_samples > Space()) {
+        return false;
+    }
+    const int tail = (head_ + size_) % std::max(1, capacity_);
+    const int first = std::min(nb_samples, capacity_ - tail);
+    const int second = nb_samples - first;
+    const std::size_t unit = static_cast<std::size_t>(sample_bytes_);
+    for (int p = 0; p < planes_; ++p) {
+        uint8_t* plane = Plane(p);
+        std::memcpy(plane + static_cast<std::size_t>(tail) * unit, data[p], static_cast<std::size_t>(first) * unit);
+        if (second > 0) {
+            std::memcpy(plane, data[p] + static_cast<std::size_t>(first) * unit, static_cast<std::size_t>(second) * unit);
+        }
+    }
+    size_ += nb_samples;
+    return true;
+}
+
+bool SampleRingBuffer::CanConvert(AVSampleFormat from, AVSampleFormat to, int channels) {
+    const AVSampleFormat packed_from = av_get_packed_sample_fmt(from);
+    const AVSampleFormat packed_to = av_get_packed_sample_fmt(to);
+    if (packed_from == packed_to) {
+        return true;
+    }
+    const bool s16_float = (packed_from == AV_SAMPLE_FMT_S16 && packed_to == AV_SAMPLE_FMT_FLT) ||
+                           (packed_from == AV_SAMPLE_FMT_FLT && packed_to == AV_SAMPLE_FMT_S16);
+    const bool same_layout = channels == 1 || av_sample_fmt_is_planar(from) == av_sample_fmt_is_planar(to);
+    return s16_float && (same_layout || channels <= kMaxKernelChannels);
+}
+
+bool SampleRingBuffer::WriteConverted(const uint8_t* const* data, int nb_samples, AVSampleFormat source_fmt) {
+    if (source_fmt == sample_fmt_) {
+        return Write(data, nb_samples);
+    }
+    if (nb_samples < 0 || nb_samples > Space()) {
+        return false;
+    }
+    if (!CanConvert(source_fmt, sample_fmt_, channels_)) {
+        throw std::runtime_error("Unsupported sample conversion");
+    }
+    // Convert in blocks that never straddle the wrap point.
+    int position = (head_ + size_) % std::max(1, capacity_);
+    int done = 0;
+    while (done < nb_samples) {
+        const int count = std::min({nb_samples - done, capacity_ - position, kConvertBlock});
+        ConvertBlock(data, source_fmt, done, position, count);
+        done += count;
+        position = (position + count) % capacity_;
+    }
+    size_ += nb_samples;
+    return true;
+}
+
+void SampleRingBuffer::ConvertBlock(const uint8_t* const* data,
+                                    AVSampleFormat source_fmt,
+                                    int src_offset,
+                                    int dst_offset,
+                                    int count) {
+    const int channels = channels_;
+    const bool src_planar = channels > 1 && av_sample_fmt_is_planar(source_fmt) != 0;
+    const bool dst_planar = planes_ > 1;
+    const int src_bytes = av_get_bytes_per_sample(source_fmt);
+    const bool same_type = av_get_packed_sample_fmt(source_fmt) == av_get_packed_sample_fmt(sample_fmt_);
+    const std::size_t n = static_cast<std::size_t>(count);
+
+    // Plane pointers for both sides at the current offsets.
+    const int src_planes = src_planar ? channels : 1;
+    const std::size_t src_unit = static_cast<std::size_t>(src_planar ? src_bytes : src_bytes * channels);
+    const uint8_t* src[kMaxKernelChannels] = {};
+    uint8_t* dst[kMaxKernelChannels] = {};
+    const bool fits = channels <= kMaxKernelChannels;
+    if (fits) {
+        for (int p = 0; p < src_planes; ++p) {
+            src[p] = data[p] + static_cast<std::size_t>(src_offset) * src_unit;
+        }
+        for (int p = 0; p < planes_; ++p) {
+            dst[p] = Plane(p) + static_cast<std::size_t>(dst_offset) * static_cast<std::size_t>(sample_bytes_);
+        }
+    }
+
+    if (same_type) {
+        if (bytes_per_sample_ == 4 && fits) {
+            if (dst_planar) {
+                SampleKernels::Deinterleave32(reinterpret_cast<const uint32_t*>(src[0]),
+                                              reinterpret_cast<uint32_t* const*>(dst), n, channels);
+            } else {
+                SampleKernels::Interleave32(reinterpret_cast<const uint32_t* const*>(src),
+                                            reinterpret_cast<uint32_t*>(dst[0]), n, channels);
+            }
+            return;
+        }
+        switch (bytes_per_sample_) {
+            case 1:
+                Repack<uint8_t>(!dst_planar, data, src_offset, storage_, plane_stride_, dst_offset, count, channels);
+                break;
+            case 2:
+                Repack<uint16_t>(!dst_planar, data, src_offset, storage_, plane_stride_, dst_offset, count, channels);
+                break;
+            case 4:
+                Repack<uint32_t>(!dst_planar, data, src_offset, storage_, plane_stride_, dst_offset, count, channels);
+                break;
+            case 8:
+                Repack<uint64_t>(!dst_planar, data, src_offset, storage_, plane_stride_, dst_offset, count, channels);
+                break;
+            default:
+                throw std::runtime_error("Unsupported sample size for repacking");
+        }
+        return;
+    }
+
+    const bool to_float = av_get_packed_sample_fmt(sample_fmt_) == AV_SAMPLE_FMT_FLT;
+    if (src_planar == dst_planar) {
+        // Same layout: convert each plane in one pass.
+        const std::size_t values = dst_planar ? n : n * static_cast<std::size_t>(channels);
+        for (int p = 0; p < planes_; ++p) {
+            const uint8_t* in = data[p] + static_cast<std::size_t>(src_offset) * src_unit;
+            uint8_t* out = Plane(p) + static_cast<std::size_t>(dst_offset) * static_cast<std::size_t>(sample_bytes_);
+            if (to_float) {
+                SampleKernels::S16ToFloat(reinterpret_cast<const int16_t*>(in), reinterpret_cast<float*>(out), values);
+            } else {
+                SampleKernels::FloatToS16(reinterpret_cast<const float*>(in), reinterpret_cast<int16_t*>(out), values);
+            }
+        }
+        return;
+    }
+
+    // Type and layout both change: stage the block as float in scratch, then finish the other step.
+    alignas(32) float scratch[kConvertBlock * kMaxKernelChannels];
+    uint32_t* scratch_planes[kMaxKernelChannels];
+    for (int c = 0; c < channels; ++c) {
+        scratch_planes[c] = reinterpret_cast<uint32_t*>(scratch + static_cast<std::size_t>(c) * kConvertBlock);
+    }
+    const std::size_t values = n * static_cast<std::size_t>(channels);
+    if (to_float && dst_planar) {
+        SampleKernels::S16ToFloat(reinterpret_cast<const int16_t*>(src[0]), scratch, values);
+        SampleKernels::Deinterleave32(reinterpret_cast<const uint32_t*>(scratch),
+                                      reinterpret_cast<uint32_t* const*>(dst), n, channels);
+    } else if (to_float) {
+        for (int c = 0; c < channels; ++c) {
+            SampleKernels::S16ToFloat(reinterpret_cast<const int16_t*>(src[c]),
+                                      reinterpret_cast<float*>(scratch_planes[c]), n);
+        }
+        SampleKernels::Interleave32(scratch_planes, reinterpret_cast<uint32_t*>(dst[0]), n, channels);
+    } else if (dst_planar) {
+        SampleKernels::Deinterleave32(reinterpret_cast<const uint32_t*>(src[0]), scratch_planes, n, channels);
+        for (int c = 0; c < channels; ++c) {
+            SampleKernels::FloatToS16(reinterpret_cast<const float*>(scratch_planes[c]),
+                                      reinterpret_cast<int16_t*>(dst[c]), n);
+        }
+    } else {
+        SampleKernels::Interleave32(reinterpret_cast<const uint32_t* const*>(src),
+                                    reinterpret_cast<uint32_t*>(scratch), n, channels);
+        SampleKernels::FloatToS16(scratch, reinterpret_cast<int16_t*>(dst[0]), values);
+    }
+}
+
+bool SampleRingBuffer::Read(uint8_t* const* data, int nb_samples) {
+    if (nb_samples < 0 || nb_samples > size_) {
+        return false;
+    }
+    const int first = std::min(nb_samples, capacity_ - head_);
+    const int second = nb_samples - first;
+    const std::size_t unit = static_cast<std::size_t>(sample_bytes_);
+    for (int p = 0; p < planes_; ++p) {
+        const uint8_t* plane = Plane(p);
+        std::memcpy(data[p], plane + static_cast<std::size_t>(head_) * unit, static_cast<std::size_t>(first) * unit);
+        if (second > 0) {
+            std::memcpy(data[p] + static_cast<std::size_t>(first) * unit, plane, static_cast<std::size_t>(second) * unit);
+        }
+    }
+    head_ = (head_ + nb_samples) % capacity_;
+    size_ -= nb_samples;
+    return true;
+}
+
+void SampleRingBuffer::Discard(int nb_samples) {
+    nb_samples = std::max(0, std::min(nb_samples, size_));
+    if (nb_samples == 0) {
+        return;
+    }
+    head_ = (head_ + nb_samples) % capacity_;
+    size_ -= nb_samples;
+}
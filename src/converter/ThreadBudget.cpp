@@ -0,0 +1,102 @@
+#include "converter/ThreadBudget.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+int ResolveCapacity(int capacity) {
+    if (capacity > 0) {
+        return capacity;
+    }
+    return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+}
+
+ThreadBudget::Lease::~Lease() {
+    if (budget_ != nullptr && threads_ > 0) {
+        budget_->Release(threads_);
+    }
+}
+
+ThreadBudget::Lease::Lease(Lease&& other) noexcept
+    : budget_(other.budget_),
+      threads_(other.threads_) {
+    other.budget_ = nullptr;
+    other.threads_ = 0;
+}
+
+ThreadBudget::Lease& ThreadBudget::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        if (budget_ != nullptr && threads_ > 0) {
+            budget_->Release(threads_);
+        }
+        budget_ = other.budget_;
+        threads_ = other.threads_;
+        other.budget_ = nullptr;
+        other.threads_ = 0;
+    }
+    return *this;
+}
+
+void ThreadBudget::Lease::Shrink(int threads) {
+    threads = std::max(1, threads);
+    if (budget_ == nullptr || threads >= threads_) {
+        return;
+    }
+    budget_->Release(threads_ - threads);
+    threads_ = threads;
+}
+
+ThreadBudget::ThreadBudget(int capacity)
+    : capacity_(ResolveCapacity(capacity)) {}
+
+ThreadBudget& ThreadBudget::Global() {
+    static ThreadBudget budget;
+    return budget;
+}
+
+void ThreadBudget::SetCapacity(int capacity) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = ResolveCapacity(capacity);
+    }
+    released_.notify_all();
+}
+
+int ThreadBudget::Capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+}
+
+int ThreadBudget::Available() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::max(0, capacity_ - in_use_);
+}
+
+ThreadBudget::Lease ThreadBudget::Acquire(int wanted) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    released_.wait(lock, [this]() { return in_use_ < capacity_; });
+    return Lease(this, GrantLocked(wanted));
+}
+
+ThreadBudget::Lease ThreadBudget::TryAcquire(int wanted) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (in_use_ >= capacity_) {
+        return Lease();
+    }
+    return Lease(this, GrantLocked(wanted));
+}
+
+int ThreadBudget::GrantLocked(int wanted) {
+    const int granted = std::max(1, std::min(wanted, capacity_ - in_use_));
+    in_use_ += granted;
+    return granted;
+}
+
+void ThreadBudget::Release(int threads) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_use_ -= threads;
+    }
+    released_.notify_all();
+}
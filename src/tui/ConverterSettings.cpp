@@ -0,0 +1,58 @@
+#include "tui/ConverterSettings.hpp"
+
+#include <algorithm>
+#include <thread>
+
+ConverterOptions ConverterOptionsFromConfig(const ConverterConfig& config) {
+    ConverterOptions options;
+    options.pipelined = config.GetBool("pipelined", false);
+    options.mmap_input = config.GetBool("input_mmap", false);
+    options.output_buffer_bytes = static_cast<std::size_t>(std::max(0, config.GetInt("output_buffer_kib", 0))) * 1024;
+    options.segments.count = config.GetInt("segment_count", 0);
+    options.segments.min_duration_seconds = config.GetInt("segment_min_duration_sec", 1200);
+    options.segments.overlap_ms = config.GetInt("segment_overlap_ms", 500);
+    options.incremental = config.GetBool("incremental", false);
+    options.dedup_cache_dir = config.GetString("dedup_cache_dir", "");
+    options.codec_threads = std::max(0, config.GetInt("codec_threads", 0));
+    options.stream_copy = config.GetBool("stream_copy", false);
+    options.stream_copy_tolerance_percent = config.GetInt("stream_copy_tolerance_pct", 15);
+    options.probe_size_bytes = static_cast<int64_t>(std::max(0, config.GetInt("probe_size_kib", 0))) * 1024;
+    options.analyze_duration_us = static_cast<int64_t>(std::max(0, config.GetInt("analyze_duration_ms", 0))) * 1000;
+    options.fast_open = config.GetBool("fast_open", false);
+    options.reuse_codecs = config.GetBool("reuse_codecs", false);
+    return options;
+}
+
+int BitrateFromConfig(const ConverterConfig& config) {
+    return config.GetInt("opus_bitrate_kbps", 128) * 1000;
+}
+
+OpusProfile OpusProfileFromConfig(const ConverterConfig& config, const std::string& profile_name) {
+    OpusProfile profile = OpusProfile::Named(
+        profile_name.empty() ? config.GetString("opus_profile", "balanced") : profile_name);
+    const int frame_size = config.GetInt("opus_frame_size", 0);
+    if (frame_size > 0) {
+        profile.frame_size = frame_size;
+    }
+    if (!config.GetBool("opus_use_vbr", true)) {
+        profile.vbr = "off";
+    }
+    profile.Validate();
+    return profile;
+}
+
+SchedulingPolicy SchedulingPolicyFromConfig(const ConverterConfig& config, const std::string& policy_name) {
+    return SchedulingPolicyFromName(policy_name.empty() ? config.GetString("job_order", "fifo") : policy_name);
+}
+
+int WorkerCountFromConfig(const ConverterConfig& config) {
+    const int worker_count = config.GetInt("worker_count", 0);
+    if (worker_count > 0) {
+        return worker_count;
+    }
+    return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+int ThreadBudgetFromConfig(const ConverterConfig& config) {
+    return std::max(0, config.GetInt("thread_budget", 0));
+}
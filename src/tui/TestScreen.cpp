@@ -4,10 +4,15 @@
 #include "tui/TestScreen.hpp"
 
 #include <notcurses/notcurses.h>
+#include <algorithm>
 #include <cmath>
 #include <utility>
 #include <filesystem>
+#include <future>
+#include <set>
+#include <unordered_map>
 
+#include "tui/ConverterSettings.hpp"
 #include "tui/StateMachine.hpp"
 
 namespace {
@@ -45,13 +50,27 @@ TestScreen::TestScreen(ConverterConfig& config, bool& config_changed)
       job_subframe_(false, jobs_, jobs_mutex_),
       config_subframe_(true, config_, config_changed_),
       job_config_subframe_(false, config_),
-      command_subframe_() {}
+      command_subframe_() {
+    // Resume whatever the previous session left unfinished. Opt-in: an empty job_journal (the
+    // default) keeps the TUI from leaving a file in whatever directory it was started from.
+    const std::string journal_path = config_.GetString("job_journal", "");
+    if (!journal_path.empty()) {
+        try {
+            journal_ = std::make_unique<JobJournal>(journal_path);
+            jobs_ = journal_->Open();
+            if (!jobs_.empty()) {
+                command_subframe_.SetFeedback("Resumed " + std::to_string(jobs_.size()) + " unfinished jobs");
+            }
+        } catch (const std::exception& e) {
+            journal_.reset();
+            command_subframe_.SetFeedback(std::string("Job journal disabled: ") + e.what());
+        }
+    }
+}
 
 TestScreen::~TestScreen() {
     stop_flag_.store(true, std::memory_order_relaxed);
-    if (worker_.joinable()) {
-        worker_.join();
-    }
+    JoinWorkers();
 }
 
 TestScreen::FileSubframe::FileSubframe(bool is_left) : is_left_(is_left) {}
@@ -76,6 +95,17 @@ TestScreen::JobConfigSubframe::JobConfigSubframe(bool is_left, ConverterConfig&
         }
     });
     options_.push_back(Option{"use_vbr", "Use VBR", {"Yes", "No"}});
+    // Applies to the conversions started next; the first entry keeps opus_profile from the config.
+    std::vector<std::string> profiles{std::string("From config (") + config_.GetString("opus_profile", "balanced") + ")"};
+    for (const std::string& name : OpusProfile::Names()) {
+        profiles.push_back(name);
+    }
+    options_.push_back(Option{"opus_profile", "Encoder profile", profiles});
+    std::vector<std::string> orders{std::string("From config (") + config_.GetString("job_order", "fifo") + ")"};
+    for (const std::string& name : SchedulingPolicyNames()) {
+        orders.push_back(name);
+    }
+    options_.push_back(Option{"job_order", "Job order", orders});
 }
 
 TestScreen::CommandSubframe::CommandSubframe() = default;
@@ -167,24 +197,137 @@ std::filesystem::path SafeOutputPath(const std::filesystem::path& raw,
     }
     return weak;
 }
+
+// Absolute, normalized input of a job. Directory jobs keep a trailing separator (they are
+// queued with one, and ".." normalizes to one), so they have no filename.
+std::filesystem::path JobSource(const std::string& job) {
+    return std::filesystem::absolute(job).lexically_normal();
+}
+
+// Where a job writes: its input's absolute path mirrored under output_root, the same for file
+// and directory jobs, so same-named files from different folders stay apart.
+std::filesystem::path JobOutput(const std::filesystem::path& output_root, const std::filesystem::path& source) {
+    std::filesystem::path output = output_root / source.relative_path();
+    if (source.has_filename()) {
+        output.replace_extension(".opus");
+    }
+    return output;
+}
+
+// Whether directory source dir (with trailing separator) contains path, or is it.
+bool SourceWithin(const std::filesystem::path& dir, const std::filesystem::path& path) {
+    if (dir.has_filename()) {
+        return false;
+    }
+    const std::string& prefix = dir.native();
+    return path.native().compare(0, prefix.size(), prefix) == 0;
+}
 } // namespace
 
 void TestScreen::StartConversions() {
     if (converting_.load(std::memory_order_relaxed)) {
         return;
     }
-    if (worker_.joinable()) {
-        worker_.join();
-    }
+    JoinWorkers();
     std::lock_guard<std::mutex> lock(jobs_mutex_);
     if (jobs_.empty()) {
         command_subframe_.SetFeedback("No jobs to convert");
         return;
     }
+
+    // Snapshot the configuration on the UI thread so workers never read config_ concurrently.
+    const int bitrate_bps = BitrateFromConfig(config_);
+    const ConverterOptions converter_options = ConverterOptionsFromConfig(config_);
+    const int profile_choice = job_config_subframe_.Selection("opus_profile");
+    OpusProfile profile;
+    try {
+        profile = OpusProfileFromConfig(
+            config_, profile_choice > 0 ? OpusProfile::Names()[static_cast<std::size_t>(profile_choice - 1)] : "");
+    } catch (const std::exception& e) {
+        command_subframe_.SetFeedback(std::string("Error: ") + e.what());
+        return;
+    }
+    const int order_choice = job_config_subframe_.Selection("job_order");
+    SchedulingPolicy order;
+    try {
+        order = SchedulingPolicyFromConfig(
+            config_, order_choice > 0 ? SchedulingPolicyNames()[static_cast<std::size_t>(order_choice - 1)] : "");
+    } catch (const std::exception& e) {
+        command_subframe_.SetFeedback(std::string("Error: ") + e.what());
+        return;
+    }
+    std::filesystem::path raw_output = config_.GetString("output_folder", "out");
+    auto fb = [this](const std::string& msg) { command_subframe_.SetFeedback(msg); };
+    const std::filesystem::path output_root = SafeOutputPath(raw_output, std::filesystem::absolute("out"), fb);
+
+    // Concurrent workers must never write one file. Outputs mirror sources, so jobs overlap
+    // exactly when their sources do (checked on the paths alone, no disk access), or when two
+    // files differ only in extension; only the first such job is kept.
+    std::vector<std::filesystem::path> sources;
+    std::set<std::filesystem::path> targets;
+    std::vector<std::string> batch;
+    for (std::string& job : jobs_) {
+        const std::filesystem::path source = JobSource(job);
+        const bool overlaps = std::any_of(sources.begin(), sources.end(), [&](const std::filesystem::path& kept) {
+            return kept == source || SourceWithin(kept, source) || SourceWithin(source, kept);
+        });
+        if (!overlaps && (!source.has_filename() || targets.insert(JobOutput(output_root, source)).second)) {
+            sources.push_back(source);
+            batch.push_back(std::move(job));
+            continue;
+        }
+        command_subframe_.SetFeedback("Skipped " + job + ": overlaps the outputs of an earlier job");
+        RecordJob(JobJournal::Event::Removed, job);
+    }
+    jobs_ = std::move(batch);
+
+    // Workers beyond the thread budget would only wait for a lease.
+    ThreadBudget::Global().SetCapacity(ThreadBudgetFromConfig(config_));
+    const int worker_count = std::min({WorkerCountFromConfig(config_),
+                                       ThreadBudget::Global().Capacity(),
+                                       static_cast<int>(jobs_.size())});
+
     stop_flag_.store(false, std::memory_order_relaxed);
     converting_.store(true, std::memory_order_relaxed);
-    worker_ = std::thread([this]() {
-        while (!stop_flag_.load(std::memory_order_relaxed)) {
+    active_workers_.store(worker_count, std::memory_order_relaxed);
+    job_subframe_.SetWorkerCount(static_cast<std::size_t>(worker_count));
+
+    // Workers pop from the front, so the queue is put in policy order before they start.
+    // Estimating opens every queued file, so it runs off the UI thread on a snapshot of the
+    // queue and only the sort takes jobs_mutex_.
+    std::shared_future<void> scheduled;
+    if (order != SchedulingPolicy::Fifo) {
+        scheduled = std::async(std::launch::async, [this, order, bitrate_bps, converter_options, profile,
+                                                    pending = jobs_]() {
+            MP3ToOpusConverter filter(bitrate_bps, profile);
+            filter.SetOptions(converter_options);
+            std::unordered_map<std::string, double> seconds;
+            for (const std::string& job : pending) {
+                if (stop_flag_.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                try {
+                    seconds[job] = EstimateJobSeconds(job, filter);
+                } catch (const std::exception&) {
+                    // Left without an estimate; OrderJobs puts it last.
+                }
+            }
+            std::lock_guard<std::mutex> guard(jobs_mutex_);
+            OrderJobs(jobs_, order, seconds);
+        }).share();
+    }
+
+    for (int w = 0; w < worker_count; ++w) {
+        const std::size_t worker_id = static_cast<std::size_t>(w);
+        workers_.emplace_back([this, worker_id, bitrate_bps, converter_options, profile, output_root, scheduled]() {
+            MP3ToOpusConverter converter(bitrate_bps, profile);
+            converter.SetOptions(converter_options);
+            converter.SetProgressRecord(job_subframe_.ProgressFor(worker_id));
+            if (scheduled.valid()) {
+                scheduled.wait();
+            }
+
+            while (!stop_flag_.load(std::memory_order_relaxed)) {
                 std::string job_path;
                 {
                     std::lock_guard<std::mutex> guard(jobs_mutex_);
@@ -195,57 +338,76 @@ void TestScreen::StartConversions() {
                     jobs_.erase(jobs_.begin());
                 }
 
+                std::filesystem::path input(job_path);
+                job_subframe_.BeginConversionDisplay(worker_id, input.filename().string());
+                RecordJob(JobJournal::Event::Started, job_path);
                 try {
-                    const int bitrate_kbps = config_.GetInt("opus_bitrate_kbps", 128);
-                    MP3ToOpusConverter converter(bitrate_kbps * 1000);
-                    std::filesystem::path input(job_path);
-                    std::filesystem::path raw_output = config_.GetString("output_folder", "out");
-                    auto fb = [this](const std::string& msg) { command_subframe_.SetFeedback(msg); };
-                    std::filesystem::path output_root = SafeOutputPath(raw_output, std::filesystem::absolute("out"), fb);
-                    job_subframe_.BeginConversionDisplay(input.filename().string());
-                    if (!std::filesystem::exists(output_root)) {
+                    std::error_code ec;
+                    if (!std::filesystem::exists(output_root, ec)) {
                         std::filesystem::create_directories(output_root);
                         // Restrict permissions (best-effort, POSIX).
                         std::filesystem::permissions(output_root,
                                                      std::filesystem::perms::owner_all,
-                                                     std::filesystem::perm_options::replace);
+                                                     std::filesystem::perm_options::replace,
+                                                     ec);
                     }
+                    const std::filesystem::path output = JobOutput(output_root, JobSource(job_path));
                     if (std::filesystem::is_directory(input)) {
-                    converter.ConvertDirectory(input.string(), output_root.string());
-                } else {
-                    std::filesystem::path out_file = output_root / input.filename();
-                    out_file.replace_extension(".opus");
-                    converter.SetProgressCallback([this](double p) {
-                        job_subframe_.UpdateProgress(p);
-                    });
-                    converter.ConvertFile(input.string(), out_file.string());
-                    command_subframe_.SetFeedback(std::string("Converted ") + input.filename().string() + ".");
-                }
-                    job_subframe_.EndConversionDisplay();
+                        converter.ConvertDirectory(input.string(), output.string());
+                        RecordJob(JobJournal::Event::Finished, job_path);
+                    } else {
+                        std::filesystem::create_directories(output.parent_path());
+                        converter.ConvertFile(input.string(), output.string());
+                        RecordJob(JobJournal::Event::Finished, job_path);
+                        command_subframe_.SetFeedback(std::string("Converted ") + input.filename().string() + ".");
+                    }
                 } catch (const std::exception& e) {
-                    command_subframe_.SetFeedback(std::string("Error: ") + e.what());
-                    job_subframe_.EndConversionDisplay();
-                    break;
+                    // Report and keep draining the queue; one bad file should not idle the whole pool.
+                    command_subframe_.SetFeedback(std::string("Error: ") + input.filename().string() + ": " + e.what());
+                    RecordJob(JobJournal::Event::Failed, job_path);
                 }
+                job_subframe_.EndConversionDisplay(worker_id);
             }
 
-        if (!stop_flag_.load(std::memory_order_relaxed)) {
-            command_subframe_.SetFeedback("All jobs finished.");
-        } else {
-            command_subframe_.SetFeedback("Conversion stopped");
-        }
-        converting_.store(false, std::memory_order_relaxed);
-    });
+            // The last worker out reports the batch outcome.
+            if (active_workers_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (!stop_flag_.load(std::memory_order_relaxed)) {
+                    command_subframe_.SetFeedback("All jobs finished.");
+                } else {
+                    command_subframe_.SetFeedback("Conversion stopped");
+                }
+                converting_.store(false, std::memory_order_relaxed);
+            }
+        });
+    }
 }
 
 void TestScreen::StopConversions() {
     stop_flag_.store(true, std::memory_order_relaxed);
-    if (worker_.joinable()) {
-        worker_.join();
-    }
+    JoinWorkers();
     converting_.store(false, std::memory_order_relaxed);
 }
 
+void TestScreen::JoinWorkers() {
+    for (std::thread& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+}
+
+void TestScreen::RecordJob(JobJournal::Event event, const std::string& job) {
+    if (journal_ == nullptr) {
+        return;
+    }
+    try {
+        journal_->Record(event, job);
+    } catch (const std::exception& e) {
+        command_subframe_.SetFeedback(std::string("Job journal error: ") + e.what());
+    }
+}
+
 void TestScreen::HandleInput(StateMachine& machine,
                              ncpp::NotCurses& nc,
                              ncpp::Plane& stdplane,
@@ -295,14 +457,18 @@ void TestScreen::HandleInput(StateMachine& machine,
             if (entry->is_dir && entry->name != "..") {
                 full /= "";
             }
+            std::lock_guard<std::mutex> lock(jobs_mutex_);
             jobs_.push_back(full.string());
+            RecordJob(JobJournal::Event::Enqueued, jobs_.back());
         }
         return;
     }
 
     if (focus_ == Focus::Jobs && input == 's') {
-        std::string removed = job_subframe_.RemoveSelected();
-        (void)removed;
+        const std::string removed = job_subframe_.RemoveSelected();
+        if (!removed.empty()) {
+            RecordJob(JobJournal::Event::Removed, removed);
+        }
         return;
     }
 
@@ -505,22 +671,63 @@ void TestScreen::JobSubframe::DrawContents() {
     }
     plane_->perimeter_rounded(0, channels, 0);
     plane_->putstr(0, ncpp::NCAlign::Center, "Job List");
-    if (converting_display_) {
+    bool any_active = false;
+    {
+        std::lock_guard<std::mutex> lock(convert_mutex_);
+        for (const WorkerSlot& slot : worker_slots_) {
+            any_active = any_active || slot.active;
+        }
+    }
+    if (any_active) {
         const int pad_top = 1;
         const int pad_left = 2;
         const int pad_bottom = 1;
         const int pad_right = 2;
         const ContentArea area = ContentBox(pad_top, pad_left, pad_bottom, pad_right, 0, 0);
-        plane_->putstr(area.top, area.left, "Converting:");
-        plane_->putstr(area.top + 1, area.left, converting_file_.c_str());
-        const int bar_width = std::max(1, area.width - 1);
-        const int bar_row = area.top + 2;
-        DrawProgressBar(bar_row, area.left, bar_width);
+        DrawWorkers(area);
     } else {
         DrawList();
     }
 }
 
+void TestScreen::JobSubframe::DrawWorkers(const ContentArea& area) {
+    std::vector<WorkerSlot> slots;
+    {
+        std::lock_guard<std::mutex> lock(convert_mutex_);
+        slots = worker_slots_;
+    }
+
+    // One row per active worker: file name on the left, its progress bar on the right.
+    const int name_width = std::max(1, area.width / 2 - 1);
+    const int bar_left = area.left + name_width + 1;
+    const int bar_width = std::max(1, area.left + area.width - 1 - bar_left);
+    plane_->putstr(area.top, area.left, "Converting:");
+    int row = area.top + 1;
+    const int last_row = area.top + area.height - 1;
+    int hidden = 0;
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+        const WorkerSlot& slot = slots[i];
+        if (!slot.active) {
+            continue;
+        }
+        if (row > last_row || (row == last_row && hidden == 0 && i + 1 < slots.size())) {
+            ++hidden;
+            continue;
+        }
+        std::string label = std::to_string(i + 1) + ": " + slot.file_name;
+        if (static_cast<int>(label.size()) > name_width) {
+            label.resize(static_cast<std::size_t>(name_width));
+        }
+        plane_->putstr(row, area.left, label.c_str());
+        DrawProgressBar(row, bar_left, bar_width, slot.progress->Read().Fraction());
+        ++row;
+    }
+    if (hidden > 0 && last_row > area.top) {
+        const std::string more = "+" + std::to_string(hidden) + " more";
+        plane_->putstr(last_row, area.left, more.c_str());
+    }
+}
+
 void TestScreen::JobSubframe::DrawList() {
     std::lock_guard<std::mutex> lock(*jobs_mutex_);
     if (jobs_ == nullptr || jobs_->empty()) {
@@ -605,29 +812,13 @@ void TestScreen::JobSubframe::DrawList() {
     plane_->set_fg_default();
 }
 
-void TestScreen::JobSubframe::DrawProgressBar(int bar_row, int bar_left, int bar_width) {
+void TestScreen::JobSubframe::DrawProgressBar(int bar_row, int bar_left, int bar_width, double value) {
     plane_->set_bg_default();
     plane_->set_fg_default();
     for (int col = 0; col < bar_width; ++col) {
         plane_->putstr(bar_row, bar_left + col, " ");
     }
-    int filled = 0;
-    bool local_converting = false;
-    double local_progress_value = 0.0;
-    {
-        std::lock_guard<std::mutex> lock(convert_mutex_);
-        local_converting = converting_display_;
-        local_progress_value = progress_value_;
-    }
-    if (local_converting) {
-        filled = static_cast<int>(local_progress_value * bar_width);
-    } else {
-        progress_ += fill_speed_;
-        if (progress_ >= static_cast<double>(bar_width)) {
-            progress_ = 0.0;
-        }
-        filled = static_cast<int>(progress_);
-    }
+    int filled = static_cast<int>(value * bar_width);
     if (filled > bar_width) {
         filled = bar_width;
     }
@@ -644,25 +835,41 @@ void TestScreen::JobSubframe::Tick() {
     // Progress advances during DrawProgressBar when width is known.
 }
 
-void TestScreen::JobSubframe::BeginConversionDisplay(const std::string& file_name) {
+void TestScreen::JobSubframe::SetWorkerCount(std::size_t count) {
+    std::lock_guard<std::mutex> lock(convert_mutex_);
+    worker_slots_.assign(count, WorkerSlot{});
+    while (progress_records_.size() < count) {
+        progress_records_.push_back(std::make_unique<ProgressRecord>());
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        worker_slots_[i].progress = progress_records_[i].get();
+    }
+}
+
+ProgressRecord* TestScreen::JobSubframe::ProgressFor(std::size_t worker) {
     std::lock_guard<std::mutex> lock(convert_mutex_);
-    converting_display_ = true;
-    converting_file_ = file_name;
-    progress_ = 0.0;
-    progress_value_ = 0.0;
+    return worker < worker_slots_.size() ? worker_slots_[worker].progress : nullptr;
 }
 
-void TestScreen::JobSubframe::EndConversionDisplay() {
+void TestScreen::JobSubframe::BeginConversionDisplay(std::size_t worker, const std::string& file_name) {
     std::lock_guard<std::mutex> lock(convert_mutex_);
-    converting_display_ = false;
-    converting_file_.clear();
-    progress_ = 0.0;
-    progress_value_ = 0.0;
+    if (worker >= worker_slots_.size()) {
+        return;
+    }
+    WorkerSlot& slot = worker_slots_[worker];
+    slot.active = true;
+    slot.file_name = file_name;
+    slot.progress->Publish(0, 0, slot.progress->Read().file_id);
 }
 
-void TestScreen::JobSubframe::UpdateProgress(double value) {
+void TestScreen::JobSubframe::EndConversionDisplay(std::size_t worker) {
     std::lock_guard<std::mutex> lock(convert_mutex_);
-    progress_value_ = value;
+    if (worker >= worker_slots_.size()) {
+        return;
+    }
+    WorkerSlot& slot = worker_slots_[worker];
+    slot.active = false;
+    slot.file_name.clear();
 }
 
 void TestScreen::JobSubframe::HandleInput(uint32_t input, const ncinput& details) {
@@ -999,6 +1206,11 @@ void TestScreen::JobConfigSubframe::DrawChoice() {
     plane_->set_fg_default();
 }
 
+int TestScreen::JobConfigSubframe::Selection(const std::string& key) const {
+    const auto it = selection_map_.find(key);
+    return it == selection_map_.end() ? -1 : it->second;
+}
+
 void TestScreen::JobConfigSubframe::HandleInput(uint32_t input, const ncinput& details) {
     (void)details;
     if (mode_ == Mode::List) {
@@ -1266,13 +1478,30 @@ void TestScreen::ConfigSubframe::EnterOptions() {
         current_options_.push_back(Option{"input_folder", "Input folder", Option::Type::String});
         current_options_.push_back(Option{"output_folder", "Output folder", Option::Type::String});
         current_options_.push_back(Option{"use_vbr", "Use VBR", Option::Type::Bool});
+        current_options_.push_back(Option{"worker_count", "Workers (0 = all cores)", Option::Type::Int});
+        current_options_.push_back(Option{"thread_budget", "Thread budget (0 = all cores)", Option::Type::Int});
+        current_options_.push_back(Option{"codec_threads", "Extra codec threads per file", Option::Type::Int});
+        current_options_.push_back(Option{"pipelined", "Pipelined decode/encode", Option::Type::Bool});
+        current_options_.push_back(Option{"input_mmap", "Memory-mapped input", Option::Type::Bool});
+        current_options_.push_back(Option{"output_buffer_kib", "Output buffer KiB (0 = off)", Option::Type::Int});
+        current_options_.push_back(Option{"segment_count", "Segments per long file (0 = off)", Option::Type::Int});
+        current_options_.push_back(Option{"segment_min_duration_sec", "Segment min duration (s)", Option::Type::Int});
+        current_options_.push_back(Option{"incremental", "Skip up-to-date outputs", Option::Type::Bool});
+        current_options_.push_back(Option{"dedup_cache_dir", "Dedup cache folder (empty = off)", Option::Type::String});
+        current_options_.push_back(Option{"stream_copy", "Copy inputs already in Opus", Option::Type::Bool});
+        current_options_.push_back(Option{"stream_copy_tolerance_pct", "Copy bitrate tolerance %", Option::Type::Int});
+        current_options_.push_back(Option{"probe_size_kib", "Probe size KiB (0 = default)", Option::Type::Int});
+        current_options_.push_back(Option{"analyze_duration_ms", "Analyze duration ms (0 = default)", Option::Type::Int});
+        current_options_.push_back(Option{"fast_open", "Trust input extension", Option::Type::Bool});
+        current_options_.push_back(Option{"reuse_codecs", "Reuse decoder/resampler across files", Option::Type::Bool});
     } else if (submenu_index_ == 1) {
         current_options_.push_back(Option{"mp3_bitrate_kbps", "MP3 bitrate kbps", Option::Type::Int});
         current_options_.push_back(Option{"mp3_use_cbr", "MP3 use CBR", Option::Type::Bool});
     } else {
         current_options_.push_back(Option{"opus_bitrate_kbps", "Opus bitrate kbps", Option::Type::Int});
         current_options_.push_back(Option{"opus_use_vbr", "Opus use VBR", Option::Type::Bool});
-        current_options_.push_back(Option{"opus_frame_size", "Opus frame size", Option::Type::Int});
+        current_options_.push_back(Option{"opus_profile", "Opus profile (fast/balanced/archival/speech)", Option::Type::String});
+        current_options_.push_back(Option{"opus_frame_size", "Opus frame size (0 = profile)", Option::Type::Int});
     }
 }
 